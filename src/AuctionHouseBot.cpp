@@ -17,6 +17,8 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+#include <random>
+
 #include "ObjectMgr.h"
 #include "AuctionHouseMgr.h"
 #include "Config.h"
@@ -27,11 +29,14 @@
 #include "ScriptMgr.h"
 
 #include "AuctionHouseBot.h"
+#include "AuctionHouseBotAliasTable.h"
 #include "AuctionHouseBotCommon.h"
 #include "AuctionHouseSearcher.h"
 
 using namespace std;
 
+AsyncCallbackProcessor<TransactionCallback> AuctionHouseBot::_writeCallbacks;
+
 AuctionHouseBot::AuctionHouseBot(uint32 account, uint32 id)
 {
     _account        = account;
@@ -41,6 +46,8 @@ AuctionHouseBot::AuctionHouseBot(uint32 account, uint32 id)
     _lastrun_h_sec  = time(NULL);
     _lastrun_n_sec  = time(NULL);
 
+    _sellCursor     = 0;
+
     _allianceConfig = NULL;
     _hordeConfig    = NULL;
     _neutralConfig  = NULL;
@@ -51,35 +58,181 @@ AuctionHouseBot::~AuctionHouseBot()
     // Nothing
 }
 
-uint32 AuctionHouseBot::getElement(std::set<uint32> set, int index, uint32 botId, uint32 maxDup, AuctionHouseObject* auctionHouse)
+AHBItemProfile const* AuctionHouseBot::getElement(std::vector<AHBItemProfile> const& bin, uint32 index, uint32 botId, uint32 maxDup, AHBConfig* config)
 {
-    std::set<uint32>::iterator it = set.begin();
-    std::advance(it, index);
+    AHBItemProfile const* profile = &bin[index];
+
+    //
+    // The amount of stacks already sold by the bot is kept up to date by the auction house hooks
+    //
+
+    if (maxDup > 0 && config->GetBotItemCount(botId, profile->ItemId) >= maxDup)
+    {
+        return NULL;
+    }
+
+    return profile;
+}
+
+void AuctionHouseBot::CommitWrites(CharacterDatabaseTransaction trans, AHBConfig* config, AHBWriteJournal& journal)
+{
+    //
+    // The world thread does not wait for the database: the memory is already up to date and, if the
+    // writes fail, the changes recorded in the journal are taken back. The journal is emptied for the
+    // next batch.
+    //
+
+    uint32          botId   = _id;
+    uint32          ahid    = config->GetAHID();
+    AHBWriteJournal written = std::move(journal);
+
+    journal = AHBWriteJournal();
+
+    _writeCallbacks.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([botId, ahid, written](bool success)
+    {
+        if (!success)
+        {
+            UndoWrites(botId, ahid, written);
+        }
+    });
+}
+
+void AuctionHouseBot::ProcessWriteCallbacks()
+{
+    _writeCallbacks.ProcessReadyCallbacks();
+}
+
+// =============================================================================
+// Take back from the market the changes of a batch of writes that did not
+// reach the database, so that the memory matches it again
+// =============================================================================
+
+void AuctionHouseBot::UndoWrites(uint32 botId, uint32 ahid, AHBWriteJournal const& journal)
+{
+    //
+    // The configurations may have been replaced by a reload since the writes were issued
+    //
+
+    AHBConfig* config = gNeutralConfig;
+
+    switch (ahid)
+    {
+    case 2:
+        config = gAllianceConfig;
+        break;
+    case 6:
+        config = gHordeConfig;
+        break;
+    default:
+        break;
+    }
+
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(config->GetAHFID());
 
-    if (maxDup > 0)
+    LOG_ERROR("module", "AHBot [{}]: database writes failed for ah {}, undoing {} new auctions, {} bids and {} buyouts",
+        botId, ahid, uint32(journal.Posts.size()), uint32(journal.Bids.size()), uint32(journal.Buyouts.size()));
+
+    //
+    // The new auctions are not in the database: take them off the market. The hooks keep the counters
+    // up to date. If a player bid on one meanwhile, the money is held by the auction, so it is saved
+    // again instead.
+    //
+
+    CharacterDatabaseTransaction trans = nullptr;
+
+    for (uint32 auctionId : journal.Posts)
     {
-        uint32 noStacks = 0;
+        AuctionEntry* auction = auctionHouse->GetAuction(auctionId);
 
-        for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
+        if (!auction)
         {
-            AuctionEntry* Aentry = itr->second;
+            LOG_ERROR("module", "AHBot [{}]: auction {} was not saved and is already gone from the market", botId, auctionId);
+            continue;
+        }
 
-            if (Aentry->owner.GetCounter() == botId)
+        Item* item = sAuctionMgr->GetAItem(auction->item_guid);
+
+        if (auction->bid != 0)
+        {
+            if (!trans)
+            {
+                trans = CharacterDatabase.BeginTransaction();
+            }
+
+            if (item)
             {
-                if (*it == Aentry->item_template)
-                {
-                    noStacks++;
-                }
+                item->FSetState(ITEM_NEW);
+                item->SaveToDB(trans);
             }
+
+            auction->SaveToDB(trans);
+
+            continue;
         }
 
-        if (noStacks >= maxDup)
+        sAuctionMgr->RemoveAItem(auction->item_guid);
+        auctionHouse->RemoveAuction(auction);
+
+        delete item;
+    }
+
+    //
+    // Saved without waiting, like any other write. A second failure is not undone again, the auctions
+    // would bounce between the memory and the database.
+    //
+
+    if (trans)
+    {
+        _writeCallbacks.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([botId, ahid](bool success)
+        {
+            if (!success)
+            {
+                LOG_ERROR("module", "AHBot [{}]: auctions with player bids could not be saved again for ah {}", botId, ahid);
+            }
+        });
+    }
+
+    //
+    // Give the bids back to the previous bidders, from the last one in case the bot bid twice on the same auction.
+    // If the bot has been outbid meanwhile, the refund already went to the bot and nothing can be restored.
+    //
+
+    for (std::vector<AHBWriteJournal::Bid>::const_reverse_iterator itr = journal.Bids.rbegin(); itr != journal.Bids.rend(); ++itr)
+    {
+        AuctionEntry* auction = auctionHouse->GetAuction(itr->AuctionId);
+
+        if (!auction || auction->bidder.GetCounter() != botId || auction->bid != itr->Price)
         {
-            return 0;
+            LOG_ERROR("module", "AHBot [{}]: bid on auction {} was not saved and cannot be restored", botId, itr->AuctionId);
+            continue;
         }
+
+        auction->bidder = itr->PreviousBidder;
+        auction->bid    = itr->PreviousBid;
+
+        //
+        // The price went down: the ranking of the buyer must be keyed again, a key left too low
+        // would keep the auction out of its sight
+        //
+
+        sAuctionMgr->GetAuctionHouseSearcher()->UpdateBid(auction);
+        config->UpdateAuctionValue(auction, auction->bid ? auction->bid : auction->startbid);
     }
 
-    return *it;
+    //
+    // The auctions bought out are still in the database, with their item: they come back with the next restart
+    //
+
+    for (uint32 auctionId : journal.Buyouts)
+    {
+        LOG_ERROR("module", "AHBot [{}]: buyout of auction {} was not saved, the auction is back after a restart", botId, auctionId);
+    }
+
+    //
+    // Compare at once the counters with the market
+    //
+
+    config->ForceBotCountersCheck();
 }
 
 uint32 AuctionHouseBot::getStackCount(AHBConfig* config, uint32 max)
@@ -99,17 +252,17 @@ uint32 AuctionHouseBot::getStackCount(AHBConfig* config, uint32 max)
 
         if (max % 5 == 0) // 5, 10, 15, 20
         {
-            ret = urand(1, 4) * 5;
+            ret = _random.Range(1, 4) * 5;
         }
 
         if (max % 4 == 0) // 4, 8, 12, 16
         {
-            ret = urand(1, 4) * 4;
+            ret = _random.Range(1, 4) * 4;
         }
 
         if (max % 3 == 0) // 3, 6, 9, 18
         {
-            ret = urand(1, 3) * 3;
+            ret = _random.Range(1, 3) * 3;
         }
 
         if (ret > max)
@@ -124,7 +277,7 @@ uint32 AuctionHouseBot::getStackCount(AHBConfig* config, uint32 max)
     // Totally random
     // 
 
-    return urand(1, max);
+    return _random.Range(1, max);
 }
 
 uint32 AuctionHouseBot::getElapsedTime(uint32 timeClass)
@@ -132,13 +285,13 @@ uint32 AuctionHouseBot::getElapsedTime(uint32 timeClass)
     switch (timeClass)
     {
     case 2:
-        return urand(1, 5) * 600;   // SHORT = In the range of one hour
+        return _random.Range(1, 5) * 600;   // SHORT = In the range of one hour
 
     case 1:
-        return urand(1, 23) * 3600; // MEDIUM = In the range of one day
+        return _random.Range(1, 23) * 3600; // MEDIUM = In the range of one day
 
     default:
-        return urand(1, 3) * 86400; // LONG = More than one day but less than three
+        return _random.Range(1, 3) * 86400; // LONG = More than one day but less than three
     }
 }
 
@@ -154,369 +307,408 @@ uint32 AuctionHouseBot::getNofAuctions(AHBConfig* config, AuctionHouseObject* au
     }
 
     //
-    // Just the one handled by the bot
+    // Just the one handled by the bot, kept up to date by the auction house hooks
     //
 
-    uint32 count = 0;
-
-    for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
-    {
-        AuctionEntry* Aentry = itr->second;
-
-        if (guid == Aentry->owner)
-        {
-            count++;
-        }
-    }
-
-    return count;
+    return config->GetBotAuctionCount(guid.GetCounter());
 }
 
 // =============================================================================
-// This routine performs the bidding/buyout operations for the bot
+// Evaluate a single auction of a player and bid on it or buy it out, returns
+// false if the operation has been postponed by the rate limit of the market
 // =============================================================================
 
-void AuctionHouseBot::Buy(Player* AHBplayer, AHBConfig* config, WorldSession* session)
+bool AuctionHouseBot::BidOnAuction(Player* AHBplayer, AHBConfig* config, WorldSession* session, AuctionHouseObject* auctionHouseObject, uint32 auctionID, uint32 bidRatePct, CharacterDatabaseTransaction& trans, AHBWriteJournal& journal)
 {
-    //
-    // Check if disabled
-    //
+    AuctionEntry* auction = auctionHouseObject->GetAuction(auctionID);
 
-    if (!config->AHBBuyer)
+    if (!auction)
     {
-        return;
+        if (config->DebugOutBuyer)
+        {
+            LOG_ERROR("module", "AHBot [{}]: Auction id: {} Possible entry to buy/bid from AH pool is invalid, this should not happen, moving on next auciton", _id, auctionID);
+        }
+        return true;
     }
 
     //
-    // Retrieve items not owned by the bot and not bought/bidded on by the bot
+    // Prevent from buying items from the other bots, or bidding against ourselves
     //
 
-    QueryResult ahContentQueryResult = CharacterDatabase.Query("SELECT id FROM auctionhouse WHERE houseid={} AND itemowner<>{} AND buyguid<>{}", config->GetAHID(), _id, _id);
-
-    if (!ahContentQueryResult)
+    if (gBotsId.find(auction->owner.GetCounter()) != gBotsId.end())
     {
-        return;
+        return true;
     }
 
-    if (ahContentQueryResult->GetRowCount() == 0)
+    if (auction->bidder.GetCounter() == _id)
     {
-        return;
+        return true;
     }
 
-    if (config->DebugOutBuyer)
+    //
+    // Get the item information
+    //
+
+    Item* pItem = sAuctionMgr->GetAItem(auction->item_guid);
+
+    if (!pItem)
     {
-        LOG_INFO("module", "AHBot [{}]: Performing Buy operations for AH={} nbOfAuctions={}", _id, config->GetAHID(), ahContentQueryResult->GetRowCount());
+        if (config->DebugOutBuyer)
+        {
+            LOG_ERROR("module", "AHBot [{}]: item {} doesn't exist, perhaps bought already?", _id, auction->item_guid.ToString());
+        }
+
+        return true;
     }
 
     //
-    // Fetches content of selected AH to look for possible bids
+    // Determine current price.
     //
+    uint32 currentPrice = auction->bid ? auction->bid : auction->startbid;
 
-    AuctionHouseObject* auctionHouseObject = sAuctionMgr->GetAuctionsMap(config->GetAHFID());
-    std::vector<uint32> auctionsGuidsToConsider;
+    //
+    // Determine maximum bid and skip auctions with too high a currentPrice.
+    //
+
+    double maximumBid = double(config->GetBuyerValuation(auction->item_template)) * auction->itemCount;
 
-    do
+    if (config->TraceBuyer)
     {
-        uint32 autionGuid = ahContentQueryResult->Fetch()->Get<uint32>();
-        auctionsGuidsToConsider.push_back(autionGuid);
-    } while (ahContentQueryResult->NextRow());
+        ItemTemplate const* prototype = sObjectMgr->GetItemTemplate(auction->item_template);
+
+        LOG_INFO("module", "-------------------------------------------------");
+        LOG_INFO("module", "AHBot [{}]: Info for Auction #{}:", _id, auction->Id);
+        LOG_INFO("module", "AHBot [{}]: AuctionHouse: {}", _id, auction->GetHouseId());
+        LOG_INFO("module", "AHBot [{}]: Owner: {}", _id, auction->owner.ToString());
+        LOG_INFO("module", "AHBot [{}]: Bidder: {}", _id, auction->bidder.ToString());
+        LOG_INFO("module", "AHBot [{}]: Starting Bid: {}", _id, auction->startbid);
+        LOG_INFO("module", "AHBot [{}]: Current Bid: {}", _id, currentPrice);
+        LOG_INFO("module", "AHBot [{}]: Buyout: {}", _id, auction->buyout);
+        LOG_INFO("module", "AHBot [{}]: Deposit: {}", _id, auction->deposit);
+        LOG_INFO("module", "AHBot [{}]: Expire Time: {}", _id, uint32(auction->expire_time));
+        LOG_INFO("module", "AHBot [{}]: Bid Max: {}", _id, maximumBid);
+        LOG_INFO("module", "AHBot [{}]: Item GUID: {}", _id, auction->item_guid.ToString());
+        LOG_INFO("module", "AHBot [{}]: Item Template: {}", _id, auction->item_template);
+        LOG_INFO("module", "AHBot [{}]: Item ID: {}", _id, prototype->ItemId);
+        LOG_INFO("module", "AHBot [{}]: Buy Price: {}", _id, prototype->BuyPrice);
+        LOG_INFO("module", "AHBot [{}]: Sell Price: {}", _id, prototype->SellPrice);
+        LOG_INFO("module", "AHBot [{}]: Bonding: {}", _id, prototype->Bonding);
+        LOG_INFO("module", "AHBot [{}]: Quality: {}", _id, prototype->Quality);
+        LOG_INFO("module", "AHBot [{}]: Item Level: {}", _id, prototype->ItemLevel);
+        LOG_INFO("module", "AHBot [{}]: Ammo Type: {}", _id, prototype->AmmoType);
+        LOG_INFO("module", "-------------------------------------------------");
+    }
 
     //
-    // If it's not possible to bid stop here
+    //  Make sure to skip the auction if maximum bid is 0, the class of the item is never bought.
     //
 
-    if (auctionsGuidsToConsider.empty())
+    if (maximumBid == 0)
     {
-        if (config->DebugOutBuyer)
+        if (config->TraceBuyer)
         {
-            LOG_INFO("module", "AHBot [{}]: no auctions to bid on has been recovered", _id);
+            LOG_INFO("module", "AHBot [{}]: Maximum bid value for item {} is 0, skipped.", _id, auction->item_template);
         }
+        return true;
+    }
 
-        return;
+    if (currentPrice > maximumBid)
+    {
+        if (config->TraceBuyer)
+        {
+            LOG_INFO("module", "AHBot [{}]: Current price too high, skipped.", _id);
+        }
+        return true;
     }
 
     //
-    // Perform the operation for a maximum amount of bids attempts configured
+    // Calculate our bid
     //
 
-    if (config->TraceBuyer)
+    double bidRate = static_cast<double>(bidRatePct) / 100;
+    double bidValue = currentPrice + ((maximumBid - currentPrice) * bidRate);
+    uint32 bidPrice = static_cast<uint32>(bidValue);
+
+
+    //
+    // Check our bid is high enough to be valid. If not, correct it to minimum.
+    //
+    uint32 minimumOutbid = auction->GetAuctionOutBid();
+    if ((currentPrice + minimumOutbid) > bidPrice)
     {
-        LOG_INFO("module", "AHBot [{}]: Considering {} auctions per interval to bid on.", _id, config->GetBidsPerInterval());
+        bidPrice = currentPrice + minimumOutbid;
     }
 
-    for (uint32 count = 1; count <= config->GetBidsPerInterval(); ++count)
+    if (bidPrice > maximumBid)
     {
-        //
-        // Choose a random auction from possible auctions
-        //
+        if (config->TraceBuyer)
+        {
+            LOG_INFO("module", "AHBot [{}]: Bid was above bidMax for item={} AH={}", _id, auction->item_guid.ToString(), config->GetAHID());
+        }
+        bidPrice = maximumBid;
+    }
 
-        uint32 randomIndex = urand(0, auctionsGuidsToConsider.size() - 1);
+    if (config->DebugOutBuyer)
+    {
+        LOG_INFO("module", "-------------------------------------------------");
+        LOG_INFO("module", "AHBot [{}]: Bid Rate: {}", _id, bidRate);
+        LOG_INFO("module", "AHBot [{}]: Bid Value: {}", _id, bidValue);
+        LOG_INFO("module", "AHBot [{}]: Bid Price: {}", _id, bidPrice);
+        LOG_INFO("module", "AHBot [{}]: Minimum Outbid: {}", _id, minimumOutbid);
+        LOG_INFO("module", "-------------------------------------------------");
+    }
+       
 
-        std::vector<uint32>::iterator itBegin = auctionsGuidsToConsider.begin();
-        //std::advance(it, randomIndex);
+    //
+    // Check whether we do normal bid, or buyout
+    //
 
-        uint32 auctionID = auctionsGuidsToConsider.at(randomIndex);
+    bool isBuyout = (auction->buyout != 0) && (bidPrice >= auction->buyout);
 
-        AuctionEntry* auction = auctionHouseObject->GetAuction(auctionID);
+    //
+    // Respect the rate of writes allowed on this market, the auction will be considered again later
+    //
 
-        //
-        // Prevent to bid again on the same auction
-        //
+    if (!(isBuyout ? config->TryConsumeBuyout() : config->TryConsumeBid()))
+    {
+        if (config->TraceBuyer)
+        {
+            LOG_INFO("module", "AHBot [{}]: Rate limit reached, auction {} deferred, buyout={}", _id, auction->Id, isBuyout);
+        }
+        return false;
+    }
 
-        auctionsGuidsToConsider.erase(itBegin + randomIndex);
+    if (!trans)
+    {
+        trans = CharacterDatabase.BeginTransaction();
+    }
 
-        if (!auction)
+    if (!isBuyout)
+    {
+        //
+        // Return money to last bidder.
+        //
+    
+        if (auction->bidder)
         {
-            if (config->DebugOutBuyer)
+            if (auction->bidder != AHBplayer->GetGUID())
             {
-                LOG_ERROR("module", "AHBot [{}]: Auction id: {} Possible entry to buy/bid from AH pool is invalid, this should not happen, moving on next auciton", _id, auctionID);
+                //
+                // Mail to last bidder and return their money
+                //
+    
+                sAuctionMgr->SendAuctionOutbiddedMail(auction, bidPrice, session->GetPlayer(), trans);
             }
-            continue;
         }
 
+        journal.Bids.push_back({ auction->Id, auction->bidder, auction->bid, bidPrice });
+    
+        auction->bidder = AHBplayer->GetGUID();
+        auction->bid = bidPrice;
+
+        sAuctionMgr->GetAuctionHouseSearcher()->UpdateBid(auction);
+        config->UpdateAuctionValue(auction, auction->bid);
+    
         //
-        // Prevent from buying items from the other bots
+        // update/save the auction into database
         //
 
-        if (gBotsId.find(auction->owner.GetCounter()) != gBotsId.end())
-        {
-            continue;
-        }
+        CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_AUCTION_BID);
+        stmt->SetData(0, auction->bidder.GetCounter());
+        stmt->SetData(1, auction->bid);
+        stmt->SetData(2, auction->Id);
+        trans->Append(stmt);
 
+        if (config->TraceBuyer)
+        {
+            LOG_INFO("module", "AHBot [{}]: New bid, itemid={}, ah={}, auctionId={} item={}, start={}, current={}, buyout={}", _id, auction->item_template, auction->GetHouseId(), auction->Id, auction->item_template, auction->startbid, currentPrice, auction->buyout);
+        }            
+    }
+    else
+    {
         //
-        // Get the item information
+        // Perform the buyout
         //
 
-        Item* pItem = sAuctionMgr->GetAItem(auction->item_guid);
-
-        if (!pItem)
+        if ((auction->bidder) && (AHBplayer->GetGUID() != auction->bidder))
         {
-            if (config->DebugOutBuyer)
-            {
-                LOG_ERROR("module", "AHBot [{}]: item {} doesn't exist, perhaps bought already?", _id, auction->item_guid.ToString());
-            }
+            //
+            //  Mail to last bidder and return their money
+            //
 
-            continue;
+            sAuctionMgr->SendAuctionOutbiddedMail(auction, auction->buyout, session->GetPlayer(), trans);
         }
 
-        //
-        // Get the item prototype
-        //
-
-        ItemTemplate const* prototype = sObjectMgr->GetItemTemplate(auction->item_template);
-
+        auction->bidder = AHBplayer->GetGUID();
+        auction->bid = auction->buyout;
 
-        //
-        // Determine current price.
-        //
-        uint32 currentPrice = auction->bid ? auction->bid : auction->startbid;
+        // 
+        // Send mails to buyer & seller
+        // 
 
-        //
-        // Determine maximum bid and skip auctions with too high a currentPrice.
-        //
+        sAuctionMgr->SendAuctionSuccessfulMail(auction, trans);
+        sAuctionMgr->SendAuctionWonMail(auction, trans);
 
-        double basePrice = config->UseBuyPriceForBuyer ? prototype->BuyPrice : prototype->SellPrice;
-        double maximumBid = basePrice * pItem->GetCount() * config->GetBuyerPrice(prototype->Quality);
+        // 
+        // Removes any trace of the item
+        // 
 
         if (config->TraceBuyer)
         {
-            LOG_INFO("module", "-------------------------------------------------");
-            LOG_INFO("module", "AHBot [{}]: Info for Auction #{}:", _id, auction->Id);
-            LOG_INFO("module", "AHBot [{}]: AuctionHouse: {}", _id, auction->GetHouseId());
-            LOG_INFO("module", "AHBot [{}]: Owner: {}", _id, auction->owner.ToString());
-            LOG_INFO("module", "AHBot [{}]: Bidder: {}", _id, auction->bidder.ToString());
-            LOG_INFO("module", "AHBot [{}]: Starting Bid: {}", _id, auction->startbid);
-            LOG_INFO("module", "AHBot [{}]: Current Bid: {}", _id, currentPrice);
-            LOG_INFO("module", "AHBot [{}]: Buyout: {}", _id, auction->buyout);
-            LOG_INFO("module", "AHBot [{}]: Deposit: {}", _id, auction->deposit);
-            LOG_INFO("module", "AHBot [{}]: Expire Time: {}", _id, uint32(auction->expire_time));
-            LOG_INFO("module", "AHBot [{}]: Bid Max: {}", _id, maximumBid);
-            LOG_INFO("module", "AHBot [{}]: Item GUID: {}", _id, auction->item_guid.ToString());
-            LOG_INFO("module", "AHBot [{}]: Item Template: {}", _id, auction->item_template);
-            LOG_INFO("module", "AHBot [{}]: Item ID: {}", _id, prototype->ItemId);
-            LOG_INFO("module", "AHBot [{}]: Buy Price: {}", _id, prototype->BuyPrice);
-            LOG_INFO("module", "AHBot [{}]: Sell Price: {}", _id, prototype->SellPrice);
-            LOG_INFO("module", "AHBot [{}]: Bonding: {}", _id, prototype->Bonding);
-            LOG_INFO("module", "AHBot [{}]: Quality: {}", _id, prototype->Quality);
-            LOG_INFO("module", "AHBot [{}]: Item Level: {}", _id, prototype->ItemLevel);
-            LOG_INFO("module", "AHBot [{}]: Ammo Type: {}", _id, prototype->AmmoType);
-            LOG_INFO("module", "-------------------------------------------------");
+            LOG_INFO("module", "AHBot [{}]: Bought , itemid={}, ah={}, item={}, start={}, current={}, buyout={}", _id, auction->item_template, AuctionHouseId(auction->GetHouseId()), auction->item_template, auction->startbid, currentPrice, auction->buyout);
         }
 
-        if (currentPrice > maximumBid)
-        {
-            if (config->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: Current price too high, skipped.", _id);
-            }
-            continue;
-        }
+        journal.Buyouts.push_back(auction->Id);
 
-        
-        //
-        // Recalculate the bid depending on the type of the item
-        //
+        ScriptMgr::instance()->OnAuctionSuccessful(auctionHouseObject, auction);
+        auction->DeleteFromDB(trans);
+        sAuctionMgr->RemoveAItem(auction->item_guid);
+        auctionHouseObject->RemoveAuction(auction);
+    }
 
-        switch (prototype->Class)
-        {
-        case ITEM_CLASS_PROJECTILE:
-            maximumBid = 0;
-            break;
-        case ITEM_CLASS_GENERIC:
-            maximumBid = 0;
-            break;
-        case ITEM_CLASS_MONEY:
-            maximumBid = 0;
-            break;
-        case ITEM_CLASS_PERMANENT:
-            maximumBid = 0;
-            break;
-        default:
-            break;
-        }
+    return true;
+}
 
-        //
-        //  Make sure to skip the auction if maximum bid is 0.
-        //
+// =============================================================================
+// This routine performs the bidding/buyout operations for the bot
+// =============================================================================
 
-        if (maximumBid == 0)
-        {
-            if (config->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: Maximum bid value for item class {} is 0, skipped.", _id, prototype->Class);
-            }
-            continue;
-        }
+void AuctionHouseBot::Buy(Player* AHBplayer, AHBConfig* config, WorldSession* session)
+{
+    //
+    // Check if disabled
+    //
 
-        //
-        // Calculate our bid
-        //
+    if (!config->AHBBuyer)
+    {
+        return;
+    }
+
+    //
+    // Retrieve the auctions of the players, kept up to date by the auction house hooks
+    //
 
-        double bidRate = static_cast<double>(urand(1, 100)) / 100;
-        double bidValue = currentPrice + ((maximumBid - currentPrice) * bidRate);
-        uint32 bidPrice = static_cast<uint32>(bidValue);
+    AuctionHouseObject* auctionHouseObject = sAuctionMgr->GetAuctionsMap(config->GetAHFID());
 
+    if (config->DebugOutBuyer)
+    {
+        LOG_INFO("module", "AHBot [{}]: Performing Buy operations for AH={} nbOfAuctions={}", _id, config->GetAHID(), config->GetPlayerAuctionsCount());
+    }
 
-        //
-        // Check our bid is high enough to be valid. If not, correct it to minimum.
-        //
-        uint32 minimumOutbid = auction->GetAuctionOutBid();
-        if ((currentPrice + minimumOutbid) > bidPrice)
-        {
-            bidPrice = currentPrice + minimumOutbid;
-        }
+    //
+    // Choose at once the distinct auctions that will be considered during this interval:
+    // the most convenient ones if they are ranked, random ones otherwise
+    //
 
-        if (bidPrice > maximumBid)
-        {
-            if (config->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: Bid was above bidMax for item={} AH={}", _id, auction->item_guid.ToString(), config->GetAHID());
-            }
-            bidPrice = maximumBid;
-        }
+    std::vector<uint32> auctionsGuidsToConsider;
 
+    if (config->BuyerValueRanked)
+    {
+        config->SelectValuableAuctions(_id, config->GetBidsPerInterval(), auctionsGuidsToConsider);
+    }
+    else
+    {
+        config->SamplePlayerAuctions(_id, _random, config->GetBidsPerInterval(), auctionsGuidsToConsider);
+    }
+
+    //
+    // If it's not possible to bid stop here
+    //
+
+    if (auctionsGuidsToConsider.empty())
+    {
         if (config->DebugOutBuyer)
         {
-            LOG_INFO("module", "-------------------------------------------------");
-            LOG_INFO("module", "AHBot [{}]: Bid Rate: {}", _id, bidRate);
-            LOG_INFO("module", "AHBot [{}]: Bid Value: {}", _id, bidValue);
-            LOG_INFO("module", "AHBot [{}]: Bid Price: {}", _id, bidPrice);
-            LOG_INFO("module", "AHBot [{}]: Minimum Outbid: {}", _id, minimumOutbid);
-            LOG_INFO("module", "-------------------------------------------------");
+            LOG_INFO("module", "AHBot [{}]: no auctions to bid on has been recovered", _id);
         }
-           
 
-        //
-        // Check whether we do normal bid, or buyout
-        //
+        return;
+    }
 
-        if ((bidPrice < auction->buyout) || (auction->buyout == 0))
-        {
-            //
-            // Return money to last bidder.
-            //
-        
-            if (auction->bidder)
-            {
-                if (auction->bidder != AHBplayer->GetGUID())
-                {
-                    //
-                    // Mail to last bidder and return their money
-                    //
-        
-                    auto trans = CharacterDatabase.BeginTransaction();        
-                    sAuctionMgr->SendAuctionOutbiddedMail(auction, bidPrice, session->GetPlayer(), trans);
-                    CharacterDatabase.CommitTransaction(trans);
-                }
-            }
-        
-            auction->bidder = AHBplayer->GetGUID();
-            auction->bid = bidPrice;
+    //
+    // Perform the operation for a maximum amount of bids attempts configured
+    //
 
-            sAuctionMgr->GetAuctionHouseSearcher()->UpdateBid(auction);
-        
-            //
-            // update/save the auction into database
-            //
-            CharacterDatabase.Execute("UPDATE auctionhouse SET buyguid = '{}', lastbid = '{}' WHERE id = '{}'", auction->bidder.GetCounter(), auction->bid, auction->Id);
+    if (config->TraceBuyer)
+    {
+        LOG_INFO("module", "AHBot [{}]: Considering {} auctions per interval to bid on.", _id, config->GetBidsPerInterval());
+    }
 
-            if (config->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: New bid, itemid={}, ah={}, auctionId={} item={}, start={}, current={}, buyout={}", _id, prototype->ItemId, auction->GetHouseId(), auction->Id, auction->item_template, auction->startbid, currentPrice, auction->buyout);
-            }            
-        }
-        else
-        {
-            //
-            // Perform the buyout
-            //
+    //
+    // Draw at once the rates used to place the bids
+    //
 
-            auto trans = CharacterDatabase.BeginTransaction();
+    std::vector<uint32> bidRates(config->GetBidsPerInterval());
+    _random.Fill(bidRates.data(), bidRates.size(), 1, 100);
 
-            if ((auction->bidder) && (AHBplayer->GetGUID() != auction->bidder))
-            {
-                //
-                //  Mail to last bidder and return their money
-                //
+    //
+    // All the bids and buyouts of the interval are saved with a single transaction
+    //
 
-                sAuctionMgr->SendAuctionOutbiddedMail(auction, auction->buyout, session->GetPlayer(), trans);
-            }
+    CharacterDatabaseTransaction trans = nullptr;
+    AHBWriteJournal              journal;
 
-            auction->bidder = AHBplayer->GetGUID();
-            auction->bid = auction->buyout;
+    for (uint32 count = 1; count <= auctionsGuidsToConsider.size(); ++count)
+    {
+        BidOnAuction(AHBplayer, config, session, auctionHouseObject, auctionsGuidsToConsider[count - 1], bidRates[count - 1], trans, journal);
+    }
+
+    if (trans)
+    {
+        CommitWrites(trans, config, journal);
+    }
+}
 
-            // 
-            // Send mails to buyer & seller
-            // 
+// =============================================================================
+// This routine evaluates the auctions of the players once their reaction time
+// is over, instead of scanning the market every bidding interval
+// =============================================================================
+
+void AuctionHouseBot::BuyReactive(Player* AHBplayer, AHBConfig* config, WorldSession* session)
+{
+    if (!config->AHBBuyer)
+    {
+        return;
+    }
 
-            sAuctionMgr->SendAuctionSuccessfulMail(auction, trans);
-            sAuctionMgr->SendAuctionWonMail(auction, trans);
+    std::vector<uint32> due;
+    config->PopDueReactiveAuctions(due);
 
-            // 
-            // Removes any trace of the item
-            // 
+    if (due.empty())
+    {
+        return;
+    }
 
-            ScriptMgr::instance()->OnAuctionSuccessful(auctionHouseObject, auction);
-            auction->DeleteFromDB(trans);
-            sAuctionMgr->RemoveAItem(auction->item_guid);
-            auctionHouseObject->RemoveAuction(auction);
+    if (config->TraceBuyer)
+    {
+        LOG_INFO("module", "AHBot [{}]: Reacting to {} new auctions in AH={}", _id, due.size(), config->GetAHID());
+    }
 
+    AuctionHouseObject* auctionHouseObject = sAuctionMgr->GetAuctionsMap(config->GetAHFID());
 
-            CharacterDatabase.CommitTransaction(trans);
+    CharacterDatabaseTransaction trans = nullptr;
+    AHBWriteJournal              journal;
 
-            if (config->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: Bought , itemid={}, ah={}, item={}, start={}, current={}, buyout={}", _id, prototype->ItemId, AuctionHouseId(auction->GetHouseId()), auction->item_template, auction->startbid, currentPrice, auction->buyout);
-            }
+    for (uint32 auctionID : due)
+    {
+        if (!BidOnAuction(AHBplayer, config, session, auctionHouseObject, auctionID, _random.Range(1, 100), trans, journal))
+        {
+            config->QueueReactiveAuction(auctionID);
         }
     }
+
+    if (trans)
+    {
+        CommitWrites(trans, config, journal);
+    }
 }
 
 // =============================================================================
-// This routine performs the selling operations for the bot
+// This routine performs the selling operations for the bot, returns false if
+// it has been interrupted because the deadline has been reached
 // =============================================================================
 
-void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
+bool AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config, std::chrono::steady_clock::time_point deadline)
 {
     // 
     // Check if disabled
@@ -524,7 +716,7 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
 
     if (!config->AHBSeller)
     {
-        return;
+        return true;
     }
 
     // 
@@ -536,7 +728,7 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
 
     if (maxTotalItems == 0)
     {
-        return;
+        return true;
     }
 
     // 
@@ -547,14 +739,34 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
 
     if (!ahEntry)
     {
-        return;
+        return true;
     }
 
     AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(config->GetAHFID());
 
     if (!auctionHouse)
     {
-        return;
+        return true;
+    }
+
+    if (std::chrono::steady_clock::now() >= deadline)
+    {
+        return false;
+    }
+
+    //
+    // Verify from time to time that the auctions counters did not drift away
+    //
+
+    config->CheckBotCounters();
+
+    //
+    // Nothing to do if the market did not change since the last time the bot filled it
+    //
+
+    if (!config->NeedsRestock(_id))
+    {
+        return true;
     }
 
     // don't mess with the AH update let server do it.
@@ -588,7 +800,9 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
             LOG_TRACE("module", "AHBot [{}]: Auctions at or above maximum", _id);
         }
 
-        return;
+        config->SetRestocked(_id);
+
+        return true;
     }
 
     if ((maxTotalItems - nbOfAuctions) >= config->ItemsPerCycle)
@@ -601,40 +815,32 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
     }
 
     // 
-    // Retrieve the configuration for this run
+    // Retrieve the configuration for this run: each category is weighted by
+    // the number of auctions still missing to reach its maximum
     // 
 
-    uint32 maxGreyTG   = config->GetMaximum(AHB_GREY_TG);
-    uint32 maxWhiteTG  = config->GetMaximum(AHB_WHITE_TG);
-    uint32 maxGreenTG  = config->GetMaximum(AHB_GREEN_TG);
-    uint32 maxBlueTG   = config->GetMaximum(AHB_BLUE_TG);
-    uint32 maxPurpleTG = config->GetMaximum(AHB_PURPLE_TG);
-    uint32 maxOrangeTG = config->GetMaximum(AHB_ORANGE_TG);
-    uint32 maxYellowTG = config->GetMaximum(AHB_YELLOW_TG);
-
-    uint32 maxGreyI    = config->GetMaximum(AHB_GREY_I);
-    uint32 maxWhiteI   = config->GetMaximum(AHB_WHITE_I);
-    uint32 maxGreenI   = config->GetMaximum(AHB_GREEN_I);
-    uint32 maxBlueI    = config->GetMaximum(AHB_BLUE_I);
-    uint32 maxPurpleI  = config->GetMaximum(AHB_PURPLE_I);
-    uint32 maxOrangeI  = config->GetMaximum(AHB_ORANGE_I);
-    uint32 maxYellowI  = config->GetMaximum(AHB_YELLOW_I);
-
-    uint32 currentGreyTG    = config->GetItemCounts(AHB_GREY_TG);
-    uint32 currentWhiteTG   = config->GetItemCounts(AHB_WHITE_TG);
-    uint32 currentGreenTG   = config->GetItemCounts(AHB_GREEN_TG);
-    uint32 currentBlueTG    = config->GetItemCounts(AHB_BLUE_TG);
-    uint32 currentPurpleTG  = config->GetItemCounts(AHB_PURPLE_TG);
-    uint32 currentOrangeTG  = config->GetItemCounts(AHB_ORANGE_TG);
-    uint32 currentYellowTG  = config->GetItemCounts(AHB_YELLOW_TG);
-
-    uint32 currentGreyItems     = config->GetItemCounts(AHB_GREY_I);
-    uint32 currentWhiteItems    = config->GetItemCounts(AHB_WHITE_I);
-    uint32 currentGreenItems    = config->GetItemCounts(AHB_GREEN_I);
-    uint32 currentBlueItems     = config->GetItemCounts(AHB_BLUE_I);
-    uint32 currentPurpleItems   = config->GetItemCounts(AHB_PURPLE_I);
-    uint32 currentOrangeItems   = config->GetItemCounts(AHB_ORANGE_I);
-    uint32 currentYellowItems   = config->GetItemCounts(AHB_YELLOW_I);
+    uint32 deficit[AHB_ITEM_TYPES];
+
+    for (uint32 type = 0; type < AHB_ITEM_TYPES; ++type)
+    {
+        uint32 maximum = config->GetMaximum(type);
+        uint32 current = config->GetItemCounts(type);
+
+        if (!config->GetBin(type).empty() && current < maximum)
+        {
+            deficit[type] = maximum - current;
+        }
+        else
+        {
+            deficit[type] = 0;
+        }
+    }
+
+    AHBAliasTable categories;
+    categories.Build(deficit, AHB_ITEM_TYPES);
+
+    AHBSellerParams sellerParams[AHB_MAX_QUALITY + 1];
+    config->GetSellerParams(sellerParams);
 
     //
     // Loop variables
@@ -644,158 +850,92 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
     uint32 binEmpty  = 0; // Tracing counter
     uint32 noNeed    = 0; // Tracing counter
     uint32 tooMany   = 0; // Tracing counter
-    uint32 loopBrk   = 0; // Tracing counter
     uint32 err       = 0; // Tracing counter
+    uint32 limited   = 0; // Tracing counter
+    uint32 nbCommits = 0; // Tracing counter
+    uint32 enqueueMs = 0; // Tracing counter: time spent handing the batches to the database workers, not the commits
+
+    //
+    // The new auctions are written in batches, a single commit is performed for
+    // the whole cycle unless a maximum batch size has been configured
+    //
+
+    CharacterDatabaseTransaction trans = nullptr;
+    AHBWriteJournal              journal;
+    uint32                       pending = 0;
+
+    bool completed = true;
 
     for (uint32 cnt = 1; cnt <= nbItemsToSellThisCycle; cnt++)
     {
-        uint32 itemTypeSelectedToSell = 0;
-        uint32 itemID = 0;
-        uint32 loopbreaker = 0;
-
         //
-        // Select, in rarity order, a new random item
+        // Stop when the time given for this tick is over, the next tick will continue
         //
 
-        while (itemID == 0 && loopbreaker <= AUCTION_HOUSE_BOT_LOOP_BREAKER)
+        if (std::chrono::steady_clock::now() >= deadline)
         {
-            loopbreaker++;
-
-            // Poor
-
-            if ((config->GreyItemsBin.size() > 0) && (currentGreyItems < maxGreyI))
-            {
-                itemTypeSelectedToSell = AHB_GREY_I;
-                itemID = getElement(config->GreyItemsBin, urand(0, config->GreyItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            if (itemID == 0 && (config->GreyTradeGoodsBin.size() > 0) && (currentGreyTG < maxGreyTG))
-            {
-                itemTypeSelectedToSell = AHB_GREY_TG;
-                itemID = getElement(config->GreyTradeGoodsBin, urand(0, config->GreyTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            // Normal
-
-            if (itemID == 0 && (config->WhiteItemsBin.size() > 0) && (currentWhiteItems < maxWhiteI))
-            {
-                itemTypeSelectedToSell = AHB_WHITE_I;
-                itemID = getElement(config->WhiteItemsBin, urand(0, config->WhiteItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            if (itemID == 0 && (config->WhiteTradeGoodsBin.size() > 0) && (currentWhiteTG < maxWhiteTG))
-            {
-                itemTypeSelectedToSell = AHB_WHITE_TG;
-                itemID = getElement(config->WhiteTradeGoodsBin, urand(0, config->WhiteTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            // Uncommon
-
-            if (itemID == 0 && (config->GreenItemsBin.size() > 0) && (currentGreenItems < maxGreenI))
-            {
-                itemTypeSelectedToSell = AHB_GREEN_I;
-                itemID = getElement(config->GreenItemsBin, urand(0, config->GreenItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            if (itemID == 0 && (config->GreenTradeGoodsBin.size() > 0) && (currentGreenTG < maxGreenTG))
-            {
-                itemTypeSelectedToSell = AHB_GREEN_TG;
-                itemID = getElement(config->GreenTradeGoodsBin, urand(0, config->GreenTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            // Rare
-
-            if (itemID == 0 && (config->BlueItemsBin.size() > 0) && (currentBlueItems < maxBlueI))
-            {
-                itemTypeSelectedToSell = AHB_BLUE_I;
-                itemID = getElement(config->BlueItemsBin, urand(0, config->BlueItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
-
-            if (itemID == 0 && (config->BlueTradeGoodsBin.size() > 0) && (currentBlueTG < maxBlueTG))
-            {
-                itemTypeSelectedToSell = AHB_BLUE_TG;
-                itemID = getElement(config->BlueTradeGoodsBin, urand(0, config->BlueTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+            completed = false;
+            break;
+        }
 
-            // Epic
+        //
+        // Select a category proportionally to its deficit, then a random item in it. An item at its
+        // duplicates limit does not use up the auction: the draw is tried again, a bounded number of
+        // times, so that the other categories get the chance to fill it.
+        //
 
-            if (itemID == 0 && (config->PurpleItemsBin.size() > 0) && (currentPurpleItems < maxPurpleI))
-            {
-                itemTypeSelectedToSell = AHB_PURPLE_I;
-                itemID = getElement(config->PurpleItemsBin, urand(0, config->PurpleItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+        if (categories.Empty())
+        {
+            binEmpty++;
 
-            if (itemID == 0 && (config->PurpleTradeGoodsBin.size() > 0) && (currentPurpleTG < maxPurpleTG))
+            if (config->DebugOutSeller)
             {
-                itemTypeSelectedToSell = AHB_PURPLE_TG;
-                itemID = getElement(config->PurpleTradeGoodsBin, urand(0, config->PurpleTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
+                LOG_ERROR("module", "AHBot [{}]: No item could be selected from the bins", _id);
             }
 
-            // Legendary
-
-            if (itemID == 0 && (config->OrangeItemsBin.size() > 0) && (currentOrangeItems < maxOrangeI))
-            {
-                itemTypeSelectedToSell = AHB_ORANGE_I;
-                itemID = getElement(config->OrangeItemsBin, urand(0, config->OrangeItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+            break;
+        }
 
-            if (itemID == 0 && (config->OrangeTradeGoodsBin.size() > 0) && (currentOrangeTG < maxOrangeTG))
-            {
-                itemTypeSelectedToSell = AHB_ORANGE_TG;
-                itemID = getElement(config->OrangeTradeGoodsBin, urand(0, config->OrangeTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+        uint32                itemTypeSelectedToSell = 0;
+        AHBItemProfile const* profile                = NULL;
 
-            // Artifact
+        for (uint32 draw = 0; draw < AHB_SELL_DRAWS && profile == NULL; ++draw)
+        {
+            itemTypeSelectedToSell = categories.Draw(_random);
 
-            if (itemID == 0 && (config->YellowItemsBin.size() > 0) && (currentYellowItems < maxYellowI))
-            {
-                itemTypeSelectedToSell = AHB_YELLOW_I;
-                itemID = getElement(config->YellowItemsBin, urand(0, config->YellowItemsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+            std::vector<AHBItemProfile> const& bin = config->GetBin(itemTypeSelectedToSell);
 
-            if (itemID == 0 && (config->YellowTradeGoodsBin.size() > 0) && (currentYellowTG < maxYellowTG))
-            {
-                itemTypeSelectedToSell = AHB_YELLOW_TG;
-                itemID = getElement(config->YellowTradeGoodsBin, urand(0, config->YellowTradeGoodsBin.size() - 1), _id, config->DuplicatesCount, auctionHouse);
-            }
+            profile = getElement(bin, _random.Range(0, bin.size() - 1), _id, config->DuplicatesCount, config);
 
-            if (itemID == 0)
+            if (profile == NULL)
             {
-                binEmpty++;
-            
-                if (config->DebugOutSeller)
-                {
-                    LOG_ERROR("module", "AHBot [{}]: No item could be selected from the bins", _id);
-                }
-            
-                break;
+                tooMany++;
             }
         }
 
-        if (itemID == 0 || loopbreaker > AUCTION_HOUSE_BOT_LOOP_BREAKER)
+        if (profile == NULL)
         {
-            loopBrk++;
             continue;
         }
 
-        // 
-        // Retrieve information about the selected item
-        // 
+        uint32                 itemID = profile->ItemId;
+        AHBSellerParams const& params = sellerParams[profile->Quality];
 
-        ItemTemplate const* prototype = sObjectMgr->GetItemTemplate(itemID);
+        //
+        // Stop when the rate of new auctions allowed on this market is over, the categories
+        // are still in deficit so the next updates will continue
+        //
 
-        if (prototype == NULL)
+        if (!config->TryConsumePost())
         {
-            err++;
-
-            if (config->DebugOutSeller)
-            {
-                LOG_ERROR("module", "AHBot [{}]: could not get prototype of item {}", _id, itemID);
-            }
-
-            continue;
+            limited++;
+            break;
         }
 
+        // 
+        // Create the item
+        // 
+
         Item* item = Item::CreateItem(itemID, 1, AHBplayer);
 
         if (item == NULL)
@@ -816,24 +956,14 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
 
         item->AddToUpdateQueueOf(AHBplayer);
 
-        uint32 randomPropertyId = Item::GenerateItemRandomPropertyId(itemID);
-
-        if (randomPropertyId != 0)
+        if (profile->RandomProperty)
         {
-            item->SetItemRandomProperties(randomPropertyId);
-        }
-
-        if (prototype->Quality > AHB_MAX_QUALITY)
-        {
-            err++;
+            uint32 randomPropertyId = Item::GenerateItemRandomPropertyId(itemID);
 
-            if (config->DebugOutSeller)
+            if (randomPropertyId != 0)
             {
-                LOG_ERROR("module", "AHBot [{}]: Quality {} TOO HIGH for item {}", _id, prototype->Quality, itemID);
+                item->SetItemRandomProperties(randomPropertyId);
             }
-
-            item->RemoveFromUpdateQueueOf(AHBplayer);
-            continue;
         }
 
         // 
@@ -851,33 +981,26 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
 
         if (buyoutPrice == 0)
         {
-            if (config->UseBuyPriceForSeller)
-            {
-                buyoutPrice = prototype->BuyPrice;
-            }
-            else
-            {
-                buyoutPrice = prototype->SellPrice;
-            }
+            buyoutPrice = profile->BasePrice;
         }
 
-        buyoutPrice = buyoutPrice * urand(config->GetMinPrice(prototype->Quality), config->GetMaxPrice(prototype->Quality));
+        buyoutPrice = buyoutPrice * _random.Range(params.MinPrice, params.MaxPrice);
         buyoutPrice = buyoutPrice / 100;
 
-        bidPrice    = buyoutPrice * urand(config->GetMinBidPrice(prototype->Quality), config->GetMaxBidPrice(prototype->Quality));
+        bidPrice    = buyoutPrice * _random.Range(params.MinBidPrice, params.MaxBidPrice);
         bidPrice    = bidPrice / 100;
 
         // 
         // Determine the stack size
         // 
 
-        if (config->GetMaxStack(prototype->Quality) > 1 && item->GetMaxStackCount() > 1)
+        if (params.MaxStack > 1 && profile->MaxStackCount > 1)
         {
-            stackCount = minValue(getStackCount(config, item->GetMaxStackCount()), config->GetMaxStack(prototype->Quality));
+            stackCount = minValue(getStackCount(config, profile->MaxStackCount), params.MaxStack);
         }
-        else if (config->GetMaxStack(prototype->Quality) == 0 && item->GetMaxStackCount() > 1)
+        else if (params.MaxStack == 0 && profile->MaxStackCount > 1)
         {
-            stackCount = getStackCount(config, item->GetMaxStackCount());
+            stackCount = getStackCount(config, profile->MaxStackCount);
         }
         else
         {
@@ -896,13 +1019,16 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
         // Determine the deposit
         // 
 
-        uint32 deposit = sAuctionMgr->GetAuctionDeposit(ahEntry, elapsingTime, item, stackCount);
+        uint32 deposit = config->GetAuctionDeposit(ahEntry, elapsingTime, item, stackCount);
 
         // 
         // Perform the auction
         // 
 
-        auto trans = CharacterDatabase.BeginTransaction();
+        if (!trans)
+        {
+            trans = CharacterDatabase.BeginTransaction();
+        }
 
         AuctionEntry* auctionEntry      = new AuctionEntry();
         auctionEntry->Id                = sObjectMgr->GenerateAuctionID();
@@ -924,75 +1050,28 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
         auctionHouse->AddAuction(auctionEntry);
         auctionEntry->SaveToDB(trans);
 
-        CharacterDatabase.CommitTransaction(trans);
-
-        // 
-        // Increments the number of items presents in the auction
-        // 
+        journal.Posts.push_back(auctionEntry->Id);
 
-        // todo: reread config for actual values, maybe an array to not rely on local count that could potentially be mismatched from config.
-        // config is updated from callback received after auctionHouseObject->AddAuction(auctionEntry);
-        // or maybe reparse the server actual value each update cycle, would need profiling.
-        switch (itemTypeSelectedToSell)
+        if (++pending >= config->PostingBatchSize && config->PostingBatchSize > 0)
         {
-        case AHB_GREY_I:
-            ++currentGreyItems;
-            break;
-
-        case AHB_WHITE_I:
-            ++currentWhiteItems;
-            break;
-
-        case AHB_GREEN_I:
-            ++currentGreenItems;
-            break;
-
-        case AHB_BLUE_I:
-            ++currentBlueItems;
-            break;
-
-        case AHB_PURPLE_I:
-            ++currentPurpleItems;
-            break;
-
-        case AHB_ORANGE_I:
-            ++currentOrangeItems;
-            break;
-
-        case AHB_YELLOW_I:
-            ++currentYellowItems;
-            break;
-
-        case AHB_GREY_TG:
-            ++currentGreyTG;
-            break;
-
-        case AHB_WHITE_TG:
-            ++currentWhiteTG;
-            break;
-
-        case AHB_GREEN_TG:
-            ++currentGreenTG;
-            break;
+            uint32 enqueueStart = getMSTime();
 
-        case AHB_BLUE_TG:
-            ++currentBlueTG;
-            break;
+            CommitWrites(trans, config, journal);
 
-        case AHB_PURPLE_TG:
-            ++currentPurpleTG;
-            break;
+            enqueueMs += getMSTimeDiff(enqueueStart, getMSTime());
+            nbCommits++;
 
-        case AHB_ORANGE_TG:
-            ++currentOrangeTG;
-            break;
+            trans   = nullptr;
+            pending = 0;
+        }
 
-        case AHB_YELLOW_TG:
-            ++currentYellowTG;
-            break;
+        // 
+        // Once a category is full it must not be drawn anymore
+        // 
 
-        default:
-            break;
+        if (--deficit[itemTypeSelectedToSell] == 0)
+        {
+            categories.Build(deficit, AHB_ITEM_TYPES);
         }
 
         nbSold++;
@@ -1003,17 +1082,43 @@ void AuctionHouseBot::Sell(Player* AHBplayer, AHBConfig* config)
         }
     }
 
+    //
+    // Once every category is full the bot can rest until the market changes
+    //
+
+    if (completed && categories.Empty())
+    {
+        config->SetRestocked(_id);
+    }
+
+    //
+    // Flush what is left of the last batch
+    //
+
+    if (trans)
+    {
+        uint32 enqueueStart = getMSTime();
+
+        CommitWrites(trans, config, journal);
+
+        enqueueMs += getMSTimeDiff(enqueueStart, getMSTime());
+        nbCommits++;
+    }
+
     if (config->TraceSeller)
     {
-        LOG_INFO("module", "AHBot [{}]: auctionhouse {}, req={}, sold={}, aboveMin={}, aboveMax={}, loopBrk={}, noNeed={}, tooMany={}, binEmpty={}, err={}", _id, config->GetAHID(), nbItemsToSellThisCycle, nbSold, aboveMin, aboveMax, loopBrk, noNeed, tooMany, binEmpty, err);
+        LOG_INFO("module", "AHBot [{}]: auctionhouse {}, req={}, sold={}, aboveMin={}, aboveMax={}, noNeed={}, tooMany={}, binEmpty={}, err={}, limited={}", _id, config->GetAHID(), nbItemsToSellThisCycle, nbSold, aboveMin, aboveMax, noNeed, tooMany, binEmpty, err, limited);
+        LOG_INFO("module", "AHBot [{}]: auctionhouse {}, commits={}, enqueueTime={}ms, itemsPerCommit={}, completed={}", _id, config->GetAHID(), nbCommits, enqueueMs, nbCommits > 0 ? nbSold / nbCommits : 0, completed);
     }
+
+    return completed;
 }
 
 // =============================================================================
 // Perform an update cycle
 // =============================================================================
 
-void AuctionHouseBot::Update()
+bool AuctionHouseBot::Update(std::chrono::steady_clock::time_point deadline)
 {
     time_t _newrun = time(NULL);
 
@@ -1023,7 +1128,68 @@ void AuctionHouseBot::Update()
 
     if (!_allianceConfig && !_hordeConfig && !_neutralConfig)
     {
-        return;
+        return true;
+    }
+
+    //
+    // The factions markets are used only if the two sides cannot interact
+    //
+
+    AHBConfig*  configs[AHB_HOUSES]  = { NULL, NULL, _neutralConfig };
+    time_t*     lastruns[AHB_HOUSES] = { &_lastrun_a_sec, &_lastrun_h_sec, &_lastrun_n_sec };
+    char const* names[AHB_HOUSES]    = { "Alliance", "Horde", "Neutral" };
+
+    if (!sWorld->getBoolConfig(CONFIG_ALLOW_TWO_SIDE_INTERACTION_AUCTION))
+    {
+        configs[0] = _allianceConfig;
+        configs[1] = _hordeConfig;
+    }
+
+    //
+    // Find out what has to be done before creating the session and the player: the sellers are skipped
+    // once the time budget of the tick is over, the buyer runs only when its interval elapsed or some
+    // reactions are due
+    //
+
+    bool sellers           = false;
+    bool buyers            = false;
+    bool buyer[AHB_HOUSES] = { false, false, false };
+    bool outOfTime         = std::chrono::steady_clock::now() >= deadline;
+
+    for (uint32 house = 0; house < AHB_HOUSES; ++house)
+    {
+        AHBConfig* config = configs[house];
+
+        if (!config)
+        {
+            continue;
+        }
+
+        sellers = sellers || config->AHBSeller;
+
+        if (!config->AHBBuyer)
+        {
+            continue;
+        }
+
+        if (config->ReactiveBuyer)
+        {
+            buyer[house] = config->HasDueReactiveAuctions();
+        }
+        else
+        {
+            buyer[house] = ((_newrun - *lastruns[house]) >= (config->GetBiddingInterval() * MINUTE)) && (config->GetBidsPerInterval() > 0);
+        }
+
+        buyers = buyers || buyer[house];
+    }
+
+    bool sell      = sellers && !outOfTime;
+    bool completed = !(sellers && outOfTime);
+
+    if (!sell && !buyers)
+    {
+        return completed;
     }
 
     //
@@ -1042,85 +1208,63 @@ void AuctionHouseBot::Update()
     LOG_INFO("module", "AHBot [{}]: Begin Performing Update Cycle", _id);
 
     //
-    // Perform update for the factions markets
+    // Sell, starting from the market that was interrupted in the previous tick
     //
 
-    if (!sWorld->getBoolConfig(CONFIG_ALLOW_TWO_SIDE_INTERACTION_AUCTION))
+    for (uint32 i = 0; sell && i < AHB_HOUSES; ++i)
     {
-        //
-        // Alliance
-        //
+        uint32 house = (_sellCursor + i) % AHB_HOUSES;
 
-        if (_allianceConfig)
+        if (!configs[house])
         {
-            if (_allianceConfig->TraceSeller)
-            {
-                LOG_INFO("module", "AHBot [{}]: Begin Sell for Alliance...", _id);
-            }
-
-            Sell(&_AHBplayer, _allianceConfig);
-
-            if (((_newrun - _lastrun_a_sec) >= (_allianceConfig->GetBiddingInterval() * MINUTE)) && (_allianceConfig->GetBidsPerInterval() > 0))
-            {
-                if (_allianceConfig->TraceBuyer)
-                {
-                    LOG_INFO("module", "AHBot [{}]: Begin Buy for Alliance...", _id);
-                }
-
-                Buy(&_AHBplayer, _allianceConfig, &_session);
-                _lastrun_a_sec = _newrun;
-            }
+            continue;
         }
 
-        //
-        // Horde
-        //
+        if (configs[house]->TraceSeller)
+        {
+            LOG_INFO("module", "AHBot [{}]: Begin Sell for {}...", _id, names[house]);
+        }
 
-        if (_hordeConfig)
+        if (!Sell(&_AHBplayer, configs[house], deadline))
         {
-            if (_hordeConfig->TraceSeller)
-            {
-                LOG_INFO("module", "AHBot [{}]: Begin Sell for Horde...", _id);
-            }
-            Sell(&_AHBplayer, _hordeConfig);
+            _sellCursor = house;
+            completed   = false;
 
-            if (((_newrun - _lastrun_h_sec) >= (_hordeConfig->GetBiddingInterval() * MINUTE)) && (_hordeConfig->GetBidsPerInterval() > 0))
-            {
-                if (_hordeConfig->TraceBuyer)
-                {
-                    LOG_INFO("module", "AHBot [{}]: Begin Buy for Horde...", _id);
-                }
-                Buy(&_AHBplayer, _hordeConfig, &_session);
-                _lastrun_h_sec = _newrun;
-            }
+            break;
         }
-
     }
 
     //
-    // Neutral
+    // Buy, the buyer is not bound to the time budget
     //
 
-    if (_neutralConfig)
+    for (uint32 house = 0; house < AHB_HOUSES; ++house)
     {
-        if (_neutralConfig->TraceSeller)
+        AHBConfig* config = configs[house];
+
+        if (!buyer[house])
         {
-            LOG_INFO("module", "AHBot [{}]: Begin Sell for Neutral...", _id);
+            continue;
         }
-        Sell(&_AHBplayer, _neutralConfig);
 
-        if (((_newrun - _lastrun_n_sec) >= (_neutralConfig->GetBiddingInterval() * MINUTE)) && (_neutralConfig->GetBidsPerInterval() > 0))
+        if (config->ReactiveBuyer)
         {
-            if (_neutralConfig->TraceBuyer)
-            {
-                LOG_INFO("module", "AHBot [{}]: Begin Buy for Neutral...", _id);
-            }
-            Buy(&_AHBplayer, _neutralConfig, &_session);
-            _lastrun_n_sec = _newrun;
+            BuyReactive(&_AHBplayer, config, &_session);
+            continue;
+        }
+
+        if (config->TraceBuyer)
+        {
+            LOG_INFO("module", "AHBot [{}]: Begin Buy for {}...", _id, names[house]);
         }
+
+        Buy(&_AHBplayer, config, &_session);
+        *lastruns[house] = _newrun;
     }
 
     ObjectAccessor::RemoveObject(&_AHBplayer);
+
+    return completed;
 }
 
 // =============================================================================
@@ -1254,6 +1398,8 @@ void AuctionHouseBot::Commands(AHBotCommand command, uint32 ahMapID, uint32 col,
         AuctionHouseObject::AuctionEntryMap::iterator itr;
         itr = auctionHouse->GetAuctionsBegin();
 
+        CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+
         //
         // Iterate through all the autions and if they belong to the bot, make them expired
         //
@@ -1265,15 +1411,23 @@ void AuctionHouseBot::Commands(AHBotCommand command, uint32 ahMapID, uint32 col,
                 // Expired NOW.
                 itr->second->expire_time = GameTime::GetGameTime().count();
 
-                uint32 id                = itr->second->Id;
-                uint32 expire_time       = itr->second->expire_time;
-
-                CharacterDatabase.Execute("UPDATE auctionhouse SET time = '{}' WHERE id = '{}'", expire_time, id);
+                CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_AUCTION_EXPIRATION);
+                stmt->SetData(0, uint32(itr->second->expire_time));
+                stmt->SetData(1, itr->second->Id);
+                trans->Append(stmt);
             }
 
             ++itr;
         }
 
+        //
+        // Nothing to take back if the expiration is not saved, the auctions are removed by the server anyway
+        //
+
+        AHBWriteJournal journal;
+
+        CommitWrites(trans, config, journal);
+
         break;
     }
     case AHBotCommand::minitems:
@@ -1424,6 +1578,8 @@ void AuctionHouseBot::Commands(AHBotCommand command, uint32 ahMapID, uint32 col,
         WorldDatabase.Execute("UPDATE mod_auctionhousebot SET buyerprice{} = '{}' WHERE auctionhouse = '{}'", color, buyerPrice, ahMapID);
 
         config->SetBuyerPrice(col, buyerPrice);
+        config->BuildBuyerValuation();
+        config->RebuildValueRanking();
 
         break;
     }
@@ -1452,6 +1608,14 @@ void AuctionHouseBot::Commands(AHBotCommand command, uint32 ahMapID, uint32 col,
     default:
         break;
     }
+
+    //
+    // The limits may have changed, let the sellers check the markets again
+    //
+
+    _allianceConfig->MarkMarketChanged();
+    _hordeConfig->MarkMarketChanged();
+    _neutralConfig->MarkMarketChanged();
 }
 
 // =============================================================================
@@ -1468,6 +1632,22 @@ void AuctionHouseBot::Initialize(AHBConfig* allianceConfig, AHBConfig* hordeConf
     _hordeConfig    = hordeConfig;
     _neutralConfig  = neutralConfig;
 
+    //
+    // Every bot owns its random stream. With a fixed seed the runs can be reproduced,
+    // each bot mixes in its own id to avoid that all of them make the same choices.
+    //
+
+    uint32 seed = sConfigMgr->GetOption<uint32>("AuctionHouseBot.RandomSeed", 0);
+
+    if (seed == 0)
+    {
+        _random.Seed((uint64(std::random_device()()) << 32) | std::random_device()());
+    }
+    else
+    {
+        _random.Seed((uint64(seed) << 32) | _id);
+    }
+
     //
     // Done
     //
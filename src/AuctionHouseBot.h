@@ -20,18 +20,41 @@
 #ifndef AUCTION_HOUSE_BOT_H
 #define AUCTION_HOUSE_BOT_H
 
+#include <chrono>
+#include <vector>
+
 #include "Common.h"
 #include "ObjectGuid.h"
+#include "AsyncCallbackProcessor.h"
 #include "AuctionHouseMgr.h"
+#include "DatabaseEnv.h"
 
 #include "AuctionHouseBotCommon.h"
 #include "AuctionHouseBotConfig.h"
+#include "AuctionHouseBotRandom.h"
 
 struct AuctionEntry;
 class  Player;
 class  WorldSession;
 
-#define AUCTION_HOUSE_BOT_LOOP_BREAKER 32
+//
+// Changes made to the market in memory by a batch of database writes, undone if the batch fails
+//
+
+struct AHBWriteJournal
+{
+    struct Bid
+    {
+        uint32     AuctionId;
+        ObjectGuid PreviousBidder;
+        uint32     PreviousBid;
+        uint32     Price;          // Bid placed by the bot
+    };
+
+    std::vector<uint32> Posts;     // Auctions created by the seller
+    std::vector<Bid>    Bids;      // Bids placed by the buyer
+    std::vector<uint32> Buyouts;   // Auctions bought out by the buyer, already removed from the market
+};
 
 class AuctionHouseBot
 {
@@ -47,30 +70,49 @@ private:
     time_t     _lastrun_h_sec;
     time_t     _lastrun_n_sec;
 
+    uint32     _sellCursor;    // Market where the seller resumes after running out of time
+
+    AHBRandom  _random;        // Random numbers used by the seller and the buyer
+
+    //
+    // Pending database writes of all the bots: they outlive the bots, which are replaced on reload
+    //
+
+    static AsyncCallbackProcessor<TransactionCallback> _writeCallbacks;
+
     //
     // Main operations
     //
 
-    void Sell(Player *AHBplayer, AHBConfig *config);
+    bool Sell(Player *AHBplayer, AHBConfig *config, std::chrono::steady_clock::time_point deadline);
     void Buy (Player *AHBplayer, AHBConfig *config, WorldSession *session);
+    void BuyReactive(Player *AHBplayer, AHBConfig *config, WorldSession *session);
+
+    bool BidOnAuction(Player* AHBplayer, AHBConfig* config, WorldSession* session, AuctionHouseObject* auctionHouseObject, uint32 auctionID, uint32 bidRatePct, CharacterDatabaseTransaction& trans, AHBWriteJournal& journal);
 
     //
     // Utilities
     //
 
+    void CommitWrites(CharacterDatabaseTransaction trans, AHBConfig* config, AHBWriteJournal& journal);
+
+    static void UndoWrites(uint32 botId, uint32 ahid, AHBWriteJournal const& journal);
+
     inline uint32 minValue(uint32 a, uint32 b) { return a <= b ? a : b; };
 
     uint32 getNofAuctions(AHBConfig* config, AuctionHouseObject* auctionHouse, ObjectGuid guid);
     uint32 getStackCount(AHBConfig* config, uint32 max);
     uint32 getElapsedTime(uint32 timeClass);
-    uint32 getElement(std::set<uint32> set, int index, uint32 botId, uint32 maxDup, AuctionHouseObject* auctionHouse);
+    AHBItemProfile const* getElement(std::vector<AHBItemProfile> const& bin, uint32 index, uint32 botId, uint32 maxDup, AHBConfig* config);
 
 public:
     AuctionHouseBot(uint32 account, uint32 id);
     ~AuctionHouseBot();
 
     void Initialize(AHBConfig* allianceConfig, AHBConfig* hordeConfig, AHBConfig* neutralConfig);
-    void Update();
+    bool Update(std::chrono::steady_clock::time_point deadline);
+
+    static void ProcessWriteCallbacks();
 
     void Commands(AHBotCommand command, uint32 ahMapID, uint32 col, char* args);
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#include "AuctionHouseBotAliasTable.h"
+
+AHBAliasTable::AHBAliasTable()
+{
+
+}
+
+void AHBAliasTable::Build(uint32 const* weights, uint32 count)
+{
+    _values.clear();
+    _probability.clear();
+    _alias.clear();
+
+    //
+    // Keep only the entries that can be selected
+    //
+
+    double total = 0.0;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        if (weights[i] > 0)
+        {
+            _values.push_back(i);
+            total += weights[i];
+        }
+    }
+
+    if (_values.empty())
+    {
+        return;
+    }
+
+    //
+    // Scale the weights so that the average column is one, then pair every
+    // column under the average with one above it (Vose's method)
+    //
+
+    uint32 size = _values.size();
+
+    _probability.resize(size);
+    _alias.resize(size);
+
+    std::vector<double> scaled(size);
+    std::vector<uint32> small;
+    std::vector<uint32> large;
+
+    for (uint32 i = 0; i < size; ++i)
+    {
+        scaled[i] = weights[_values[i]] * size / total;
+
+        if (scaled[i] < 1.0)
+        {
+            small.push_back(i);
+        }
+        else
+        {
+            large.push_back(i);
+        }
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint32 less = small.back();
+        uint32 more = large.back();
+
+        small.pop_back();
+
+        _probability[less] = scaled[less];
+        _alias[less]       = more;
+
+        scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+
+        if (scaled[more] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+
+    //
+    // What remains is full up to rounding errors
+    //
+
+    for (uint32 i : large)
+    {
+        _probability[i] = 1.0;
+        _alias[i]       = i;
+    }
+
+    for (uint32 i : small)
+    {
+        _probability[i] = 1.0;
+        _alias[i]       = i;
+    }
+}
+
+bool AHBAliasTable::Empty() const
+{
+    return _values.empty();
+}
+
+uint32 AHBAliasTable::Draw(AHBRandom& random) const
+{
+    uint32 column = random.Range(0, _values.size() - 1);
+
+    if (random.Real() < _probability[column])
+    {
+        return _values[column];
+    }
+
+    return _values[_alias[column]];
+}
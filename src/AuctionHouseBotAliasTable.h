@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#ifndef AUCTION_HOUSE_BOT_ALIAS_TABLE_H
+#define AUCTION_HOUSE_BOT_ALIAS_TABLE_H
+
+#include <vector>
+
+#include "Common.h"
+
+#include "AuctionHouseBotRandom.h"
+
+// =============================================================================
+// Walker alias table: weighted random selection with a single draw
+// =============================================================================
+
+class AHBAliasTable
+{
+private:
+    std::vector<uint32> _values;      // Indexes with a positive weight
+    std::vector<double> _probability; // Chance to keep the column instead of the alias
+    std::vector<uint32> _alias;       // Column used when the first one is rejected
+
+public:
+    AHBAliasTable();
+
+    //
+    // Build the table; entries with a zero weight will never be drawn
+    //
+
+    void   Build(uint32 const* weights, uint32 count);
+
+    bool   Empty() const;
+    uint32 Draw (AHBRandom& random) const;
+};
+
+#endif /* AUCTION_HOUSE_BOT_ALIAS_TABLE_H */
@@ -2,11 +2,15 @@
  * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
  */
 
+#include <chrono>
+#include <vector>
+
 #include "AuctionHouseMgr.h"
 #include "GameTime.h"
 
 #include "AuctionHouseBot.h"
 #include "AuctionHouseBotCommon.h"
+#include "AuctionHouseBotConfig.h"
 #include "AuctionHouseBotAuctionHouseScript.h"
 
 AHBot_AuctionHouseScript::AHBot_AuctionHouseScript() : AuctionHouseScript("AHBot_AuctionHouseScript", {
@@ -20,7 +24,7 @@ AHBot_AuctionHouseScript::AHBot_AuctionHouseScript() : AuctionHouseScript("AHBot
     AUCTIONHOUSEHOOK_ON_BEFORE_AUCTIONHOUSEMGR_UPDATE
 })
 {
-
+    _botsCursor = 0;
 }
 
 void AHBot_AuctionHouseScript::OnBeforeAuctionHouseMgrSendAuctionSuccessfulMail(
@@ -64,6 +68,27 @@ void AHBot_AuctionHouseScript::OnBeforeAuctionHouseMgrSendAuctionOutbiddedMail(
     bool&,                 /* sendNotification */
     bool&                  /* sendMail */)
 {
+    //
+    // The auction is about to get a new price, keep the buyer ranking up to date
+    //
+
+    AuctionHouseEntry const* ahEntry = sAuctionMgr->GetAuctionHouseEntryFromHouse(auction->GetHouseId());
+    AHBConfig* config = gNeutralConfig;
+
+    if (ahEntry)
+    {
+        if (AuctionHouseId(ahEntry->houseId) == AuctionHouseId::Alliance)
+        {
+            config = gAllianceConfig;
+        }
+        else if (AuctionHouseId(ahEntry->houseId) == AuctionHouseId::Horde)
+        {
+            config = gHordeConfig;
+        }
+    }
+
+    config->UpdateAuctionValue(auction, newPrice);
+
     if (oldBidder && !newBidder)
     {
         if (gBotsId.size() > 0)
@@ -108,6 +133,21 @@ void AHBot_AuctionHouseScript::OnAuctionAdd(AuctionHouseObject* /*ah*/, AuctionE
         }
     }
 
+    //
+    // Keep track of the stacks sold by each bot, used to limit the duplicates
+    //
+
+    if (gBotsId.find(auction->owner.GetCounter()) != gBotsId.end())
+    {
+        config->IncBotItemCount(auction->owner.GetCounter(), auction->item_template);
+        config->ScheduleExpiry(auction->expire_time);
+    }
+    else
+    {
+        config->AddPlayerAuction(auction);
+        config->QueueReactiveAuction(auction->Id);
+    }
+
     //
     // Consider only those auctions handled by the bots
     //
@@ -171,6 +211,19 @@ void AHBot_AuctionHouseScript::OnAuctionRemove(AuctionHouseObject* /*ah*/, Aucti
         }
     }
 
+    // Any removal, sold, expired or cancelled, may leave room for the sellers
+    config->MarkMarketChanged();
+
+    // Keep track of the stacks sold by each bot, used to limit the duplicates
+    if (gBotsId.find(auction->owner.GetCounter()) != gBotsId.end())
+    {
+        config->DecBotItemCount(auction->owner.GetCounter(), auction->item_template);
+    }
+    else
+    {
+        config->RemovePlayerAuction(auction->Id);
+    }
+
     // Consider only those auctions handled by the bots
     if (config->ConsiderOnlyBotAuctions)
     {
@@ -278,11 +331,45 @@ void AHBot_AuctionHouseScript::OnAuctionExpire(AuctionHouseObject* /*ah*/, Aucti
 void AHBot_AuctionHouseScript::OnBeforeAuctionHouseMgrUpdate()
 {
     //
-    // For every registered bot, perform an update
+    // Check how the previous database writes ended, even while the bots are being replaced
+    //
+
+    AuctionHouseBot::ProcessWriteCallbacks();
+
+    if (gBots.empty())
+    {
+        return;
+    }
+
+    //
+    // The sellers share a time budget for every tick; the deadline is not enforced when set to zero
+    //
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    if (gNeutralConfig->SellerTimeBudget > 0)
+    {
+        deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(gNeutralConfig->SellerTimeBudget);
+    }
+
+    //
+    // For every registered bot, perform an update. Start from the bot that was interrupted
+    // in the previous tick, so that every bot gets its turn when the budget is tight.
     //
 
-    for (AuctionHouseBot* bot: gBots)
+    std::vector<AuctionHouseBot*> bots(gBots.begin(), gBots.end());
+
+    uint32 first       = _botsCursor % bots.size();
+    bool   interrupted = false;
+
+    for (uint32 i = 0; i < bots.size(); ++i)
     {
-        bot->Update();
+        uint32 current = (first + i) % bots.size();
+
+        if (!bots[current]->Update(deadline) && !interrupted)
+        {
+            _botsCursor = current;
+            interrupted = true;
+        }
     }
 }
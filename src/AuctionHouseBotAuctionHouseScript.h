@@ -14,6 +14,9 @@
 
 class AHBot_AuctionHouseScript : public AuctionHouseScript
 {
+private:
+    uint32 _botsCursor; // Bot whose seller ran out of time during the last update
+
 public:
     AHBot_AuctionHouseScript();
 
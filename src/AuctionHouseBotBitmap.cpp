@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#include "AuctionHouseBotBitmap.h"
+
+AHBItemBitmap::AHBItemBitmap()
+{
+    _count = 0;
+}
+
+void AHBItemBitmap::Insert(uint32 itemId)
+{
+    uint32 word = itemId >> 6;
+    uint64 bit  = uint64(1) << (itemId & 63);
+
+    if (word >= _words.size())
+    {
+        _words.resize(word + 1, 0);
+    }
+
+    if ((_words[word] & bit) == 0)
+    {
+        _words[word] |= bit;
+        _count++;
+    }
+}
+
+void AHBItemBitmap::Clear()
+{
+    _words.clear();
+    _words.shrink_to_fit();
+
+    _count = 0;
+}
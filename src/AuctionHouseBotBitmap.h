@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#ifndef AUCTION_HOUSE_BOT_BITMAP_H
+#define AUCTION_HOUSE_BOT_BITMAP_H
+
+#include <vector>
+
+#include "Common.h"
+
+// =============================================================================
+// Set of item ids stored as one bit per id: the ids of the templates are dense
+// enough that the whole range fits in a few kilobytes
+// =============================================================================
+
+class AHBItemBitmap
+{
+private:
+    std::vector<uint64> _words;
+    uint32              _count;   // Amount of ids in the set
+
+public:
+    AHBItemBitmap();
+
+    void   Insert  (uint32 itemId);
+    void   Clear   ();
+
+    //
+    // Ids beyond the highest one inserted are simply not in the set
+    //
+
+    bool   Contains(uint32 itemId) const
+    {
+        uint32 word = itemId >> 6;
+
+        return word < _words.size() && ((_words[word] >> (itemId & 63)) & 1) != 0;
+    }
+
+    uint32 Count   () const { return _count; }
+    bool   Empty   () const { return _count == 0; }
+};
+
+#endif /* AUCTION_HOUSE_BOT_BITMAP_H */
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#include <algorithm>
+
+#include "DatabaseEnv.h"
+#include "ItemTemplate.h"
+#include "Log.h"
+#include "ObjectMgr.h"
+#include "QueryResult.h"
+
+#include "AuctionHouseBotCatalog.h"
+
+void AHBItemColumns::Append(ItemTemplate const* prototype, bool npc, bool loot, bool disabled)
+{
+    ItemId.push_back           (prototype->ItemId);
+    Class.push_back            (prototype->Class);
+    Quality.push_back          (prototype->Quality);
+    Bonding.push_back          (prototype->Bonding);
+    ItemLevel.push_back        (prototype->ItemLevel);
+    RequiredLevel.push_back    (prototype->RequiredLevel);
+    RequiredSkillRank.push_back(prototype->RequiredSkillRank);
+    AllowableClass.push_back   (prototype->AllowableClass);
+    BuyPrice.push_back         (prototype->BuyPrice);
+    SellPrice.push_back        (prototype->SellPrice);
+    Flags.push_back            (prototype->Flags);
+    Duration.push_back         (prototype->Duration);
+    MinMoneyLoot.push_back     (prototype->MinMoneyLoot);
+
+    Conjured.push_back         (prototype->IsConjuredConsumable());
+    Npc.push_back              (npc);
+    Loot.push_back             (loot);
+    Disabled.push_back         (disabled);
+}
+
+std::shared_ptr<AHBCatalog const> AHBCatalog::Load(bool debug, bool professionItems)
+{
+    std::shared_ptr<AHBCatalog> catalog = std::make_shared<AHBCatalog>();
+
+    //
+    // The bitmaps grow up to the highest id, so only the ids of actual items are kept
+    //
+
+    auto insertItem = [](AHBItemBitmap& bitmap, uint32 item)
+    {
+        if (sObjectMgr->GetItemTemplate(item))
+        {
+            bitmap.Insert(item);
+        }
+    };
+
+    //
+    // Load the list of disabled items
+    //
+
+    QueryResult result = WorldDatabase.Query("SELECT item FROM mod_auctionhousebot_disabled_items");
+
+    if (result)
+    {
+        do
+        {
+            Field* fields = result->Fetch();
+            insertItem(catalog->DisableItemStore, fields[0].Get<uint32>());
+        } while (result->NextRow());
+    }
+
+    if (debug)
+    {
+        LOG_INFO("module", "Loaded {} items from the disabled item store", catalog->DisableItemStore.Count());
+    }
+
+    //
+    // Load the list of npc items
+    //
+
+    QueryResult npcResults = WorldDatabase.Query("SELECT distinct item FROM npc_vendor");
+
+    if (npcResults)
+    {
+        do
+        {
+            Field* fields = npcResults->Fetch();
+            int32  item   = fields[0].Get<int32>();
+
+            //
+            // Negative entries are references to other vendors, not items
+            //
+
+            if (item > 0)
+            {
+                insertItem(catalog->NpcItems, item);
+            }
+
+        } while (npcResults->NextRow());
+    }
+    else
+    {
+        if (debug)
+        {
+            LOG_ERROR("module", "AuctionHouseBot: failed to retrieve npc items");
+        }
+    }
+
+    if (debug)
+    {
+        LOG_INFO("module", "Loaded {} items from NPCs", catalog->NpcItems.Count());
+    }
+
+    //
+    // Load the list from the lootable items
+    //
+
+    QueryResult itemsResults = WorldDatabase.Query(
+        "SELECT item FROM creature_loot_template      UNION "
+        "SELECT item FROM reference_loot_template     UNION "
+        "SELECT item FROM disenchant_loot_template    UNION "
+        "SELECT item FROM fishing_loot_template       UNION "
+        "SELECT item FROM gameobject_loot_template    UNION "
+        "SELECT item FROM item_loot_template          UNION "
+        "SELECT item FROM milling_loot_template       UNION "
+        "SELECT item FROM pickpocketing_loot_template UNION "
+        "SELECT item FROM prospecting_loot_template   UNION "
+        "SELECT item FROM skinning_loot_template");
+
+    if (itemsResults)
+    {
+        do
+        {
+            Field* fields = itemsResults->Fetch();
+            insertItem(catalog->LootItems, fields[0].Get<uint32>());
+
+        } while (itemsResults->NextRow());
+    }
+    else
+    {
+        if (debug)
+        {
+            LOG_ERROR("module", "AuctionHouseBot: failed to retrieve loot items");
+        }
+    }
+
+    //
+    // Include profession items
+    //
+
+    if (professionItems)
+    {
+        itemsResults = WorldDatabase.Query(
+            "SELECT item FROM auctionhousebot_professionItems");
+
+        if (itemsResults)
+        {
+            do
+            {
+                Field* fields = itemsResults->Fetch();
+                insertItem(catalog->LootItems, fields[0].Get<uint32>());
+            } while (itemsResults->NextRow());
+        }
+    }
+
+    if (debug)
+    {
+        LOG_INFO("module", "Loaded {} items from lootable items", catalog->LootItems.Count());
+    }
+
+    //
+    // Keep only the templates that any auction house could sell: with a cost and a quality up to the limit.
+    // The sorting makes the bins independent from the order of the store.
+    //
+
+    ItemTemplateContainer const* its = sObjectMgr->GetItemTemplateStore();
+
+    catalog->Templates.reserve(its->size());
+
+    for (ItemTemplateContainer::const_iterator itr = its->begin(); itr != its->end(); ++itr)
+    {
+        if ((itr->second.BuyPrice == 0) && (itr->second.SellPrice == 0))
+        {
+            continue;
+        }
+
+        if (itr->second.Quality > 6)
+        {
+            continue;
+        }
+
+        catalog->Templates.push_back(&itr->second);
+    }
+
+    std::sort(catalog->Templates.begin(), catalog->Templates.end(), [](ItemTemplate const* a, ItemTemplate const* b)
+    {
+        return a->ItemId < b->ItemId;
+    });
+
+    //
+    // Take the snapshot used by the filters, resolving once the membership to the lists
+    //
+
+    for (ItemTemplate const* prototype : catalog->Templates)
+    {
+        catalog->Columns.Append(prototype,
+            catalog->NpcItems.Contains(prototype->ItemId),
+            catalog->LootItems.Contains(prototype->ItemId),
+            catalog->DisableItemStore.Contains(prototype->ItemId));
+    }
+
+    return catalog;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#ifndef AUCTION_HOUSE_BOT_CATALOG_H
+#define AUCTION_HOUSE_BOT_CATALOG_H
+
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+
+#include "AuctionHouseBotBitmap.h"
+
+struct ItemTemplate;
+
+// =============================================================================
+// Attributes of the item templates used by the filters, stored column by column
+// so that every filter reads a single contiguous array
+// =============================================================================
+
+struct AHBItemColumns
+{
+    std::vector<uint32> ItemId;
+    std::vector<uint32> Class;
+    std::vector<uint32> Quality;
+    std::vector<uint32> Bonding;
+    std::vector<uint32> ItemLevel;
+    std::vector<uint32> RequiredLevel;
+    std::vector<uint32> RequiredSkillRank;
+    std::vector<uint32> AllowableClass;
+    std::vector<uint32> BuyPrice;
+    std::vector<uint32> SellPrice;
+    std::vector<uint32> Flags;
+    std::vector<uint32> Duration;
+    std::vector<uint32> MinMoneyLoot;
+
+    std::vector<uint8>  Conjured;
+    std::vector<uint8>  Npc;
+    std::vector<uint8>  Loot;
+    std::vector<uint8>  Disabled;
+
+    void Append(ItemTemplate const* prototype, bool npc, bool loot, bool disabled);
+};
+
+// =============================================================================
+// Facts about the items that do not depend on the auction house, loaded once
+// and shared by all the configurations: it must never be modified once built
+// =============================================================================
+
+struct AHBCatalog
+{
+    AHBItemBitmap NpcItems;         // Sold by the vendors
+    AHBItemBitmap LootItems;        // Dropped or gathered, plus the profession items when enabled
+    AHBItemBitmap DisableItemStore; // Never sold by the bots
+
+    //
+    // Item templates that could be sold at all: with a price and a valid quality, sorted by id
+    //
+
+    std::vector<ItemTemplate const*> Templates;
+    AHBItemColumns                   Columns;   // Same order as the templates
+
+    //
+    // The options are read by the caller: the catalog may be loaded by a worker thread
+    //
+
+    static std::shared_ptr<AHBCatalog const> Load(bool debug, bool professionItems);
+};
+
+#endif /* AUCTION_HOUSE_BOT_CATALOG_H */
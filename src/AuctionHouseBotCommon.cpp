@@ -20,3 +20,9 @@ AHBConfig* gNeutralConfig  = new AHBConfig(7);
 
 std::set<uint32>           gBotsId;
 std::set<AuctionHouseBot*> gBots;
+
+//
+// Set while the configurations are rebuilt after a reload: the changes made in the meantime would be lost
+//
+
+bool gConfigsRebuilding = false;
@@ -72,6 +72,39 @@ class AuctionHouseBot;
 #define AHB_YELLOW_I         13
 
 #define AHB_ITEM_TYPE_OFFSET 7
+#define AHB_ITEM_TYPES       14
+
+#define AHB_HOUSES           3
+
+//
+// Smallest amount of item templates worth a filtering thread
+//
+
+#define AHB_MIN_FILTER_RANGE 4096
+
+//
+// Largest amount of threads filtering the item templates, the world keeps running meanwhile on a reload
+//
+
+#define AHB_FILTER_THREADS   4
+
+//
+// Amount of item templates used to measure how selective every filter is
+//
+
+#define AHB_FILTER_SAMPLES   1024
+
+//
+// Largest amount of deposits remembered by every auction house
+//
+
+#define AHB_DEPOSIT_CACHE    16384
+
+//
+// Draws tried by the seller for a single auction before giving it up, when the items drawn are at their duplicates limit
+//
+
+#define AHB_SELL_DRAWS       8
 
 //
 // Chat GM commands
@@ -104,4 +137,6 @@ enum class AHBotCommand : uint32
 extern std::set<uint32>           gBotsId; // Active bots players ids
 extern std::set<AuctionHouseBot*> gBots;   // Active bots
 
+extern bool gConfigsRebuilding;            // New configurations are being built after a reload
+
 #endif // AUCTION_HOUSE_BOT_COMMON_H
@@ -17,6 +17,13 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <thread>
+
 #include "AuctionHouseMgr.h"
 #include "Common.h"
 #include "Config.h"
@@ -202,9 +209,21 @@ AHBConfig::AHBConfig(uint32 ahid, AHBConfig* conf)
     AHBSeller                      = conf->AHBSeller;
     AHBBuyer                       = conf->AHBBuyer;
     UseBuyPriceForBuyer            = conf->UseBuyPriceForBuyer;
+    BuyerValueRanked               = conf->BuyerValueRanked;
+    ReactiveBuyer                  = conf->ReactiveBuyer;
+    ReactiveBuyerMinDelay          = conf->ReactiveBuyerMinDelay;
+    ReactiveBuyerMaxDelay          = conf->ReactiveBuyerMaxDelay;
     UseBuyPriceForSeller           = conf->UseBuyPriceForSeller;
     ConsiderOnlyBotAuctions        = conf->ConsiderOnlyBotAuctions;
     ItemsPerCycle                  = conf->ItemsPerCycle;
+    CountersCheckInterval          = conf->CountersCheckInterval;
+    PostingBatchSize               = conf->PostingBatchSize;
+    SellerTimeBudget               = conf->SellerTimeBudget;
+    MaxPostsPerSecond              = conf->MaxPostsPerSecond;
+    MaxBidsPerSecond               = conf->MaxBidsPerSecond;
+    MaxBuyoutsPerSecond            = conf->MaxBuyoutsPerSecond;
+    RateLimitBurst                 = conf->RateLimitBurst;
+    RandomSeed                     = conf->RandomSeed;
     Vendor_Items                   = conf->Vendor_Items;
     Loot_Items                     = conf->Loot_Items;
     Other_Items                    = conf->Other_Items;
@@ -261,118 +280,33 @@ AHBConfig::AHBConfig(uint32 ahid, AHBConfig* conf)
     // Copy the sets
     //
 
-    NpcItems.clear();
-    for (uint32 id: conf->NpcItems)
-    {
-        NpcItems.insert(id);
-    }
-
-    LootItems.clear();
-    for (uint32 id: conf->LootItems)
-    {
-        LootItems.insert(id);
-    }
-
-    DisableItemStore.clear();
-    for (uint32 id: conf->DisableItemStore)
-    {
-        DisableItemStore.insert(id);
-    }
-
-    SellerWhiteList.clear();
-    for (uint32 id: conf->SellerWhiteList)
-    {
-        SellerWhiteList.insert(id);
-    }
-
-    GreyTradeGoodsBin.clear();
-    for (uint32 id: conf->GreyTradeGoodsBin)
-    {
-        GreyTradeGoodsBin.insert(id);
-    }
-
-    WhiteTradeGoodsBin.clear();
-    for (uint32 id: conf->WhiteTradeGoodsBin)
-    {
-        WhiteTradeGoodsBin.insert(id);
-    }
-
-    GreenTradeGoodsBin.clear();
-    for (uint32 id: conf->GreenTradeGoodsBin)
-    {
-        GreenTradeGoodsBin.insert(id);
-    }
-
-    BlueTradeGoodsBin.clear();
-    for (uint32 id: conf->BlueTradeGoodsBin)
-    {
-        BlueTradeGoodsBin.insert(id);
-    }
-
-    PurpleTradeGoodsBin.clear();
-    for (uint32 id: conf->PurpleTradeGoodsBin)
-    {
-        PurpleTradeGoodsBin.insert(id);
-    }
-
-    OrangeTradeGoodsBin.clear();
-    for (uint32 id: conf->OrangeTradeGoodsBin)
-    {
-        OrangeTradeGoodsBin.insert(id);
-    }
+    catalog         = conf->catalog;
+    SellerWhiteList = conf->SellerWhiteList;
 
-    YellowTradeGoodsBin.clear();
-    for (uint32 id: conf->YellowTradeGoodsBin)
-    {
-        YellowTradeGoodsBin.insert(id);
-    }
+    SellerWhiteListConfigured = conf->SellerWhiteListConfigured;
 
+    GreyTradeGoodsBin   = conf->GreyTradeGoodsBin;
+    WhiteTradeGoodsBin  = conf->WhiteTradeGoodsBin;
+    GreenTradeGoodsBin  = conf->GreenTradeGoodsBin;
+    BlueTradeGoodsBin   = conf->BlueTradeGoodsBin;
+    PurpleTradeGoodsBin = conf->PurpleTradeGoodsBin;
+    OrangeTradeGoodsBin = conf->OrangeTradeGoodsBin;
+    YellowTradeGoodsBin = conf->YellowTradeGoodsBin;
 
     //
     // Bins for items
     //
 
-    GreyItemsBin.clear();
-    for (uint32 id: conf->GreyItemsBin)
-    {
-        GreyItemsBin.insert(id);
-    }
-
-    WhiteItemsBin.clear();
-    for (uint32 id: conf->WhiteItemsBin)
-    {
-        WhiteItemsBin.insert(id);
-    }
-
-    GreenItemsBin.clear();
-    for (uint32 id: conf->GreenItemsBin)
-    {
-        GreenItemsBin.insert(id);
-    }
-
-    BlueItemsBin.clear();
-    for (uint32 id: conf->BlueItemsBin)
-    {
-        BlueItemsBin.insert(id);
-    }
-
-    PurpleItemsBin.clear();
-    for (uint32 id: conf->PurpleItemsBin)
-    {
-        PurpleItemsBin.insert(id);
-    }
-
-    OrangeItemsBin.clear();
-    for (uint32 id: conf->OrangeItemsBin)
-    {
-        OrangeItemsBin.insert(id);
-    }
+    GreyItemsBin        = conf->GreyItemsBin;
+    WhiteItemsBin       = conf->WhiteItemsBin;
+    GreenItemsBin       = conf->GreenItemsBin;
+    BlueItemsBin        = conf->BlueItemsBin;
+    PurpleItemsBin      = conf->PurpleItemsBin;
+    OrangeItemsBin      = conf->OrangeItemsBin;
+    YellowItemsBin      = conf->YellowItemsBin;
 
-    YellowItemsBin.clear();
-    for (uint32 id: conf->YellowItemsBin)
-    {
-        YellowItemsBin.insert(id);
-    }
+    ConfigureRateLimits();
+    SeedRandom();
 }
 
 AHBConfig::~AHBConfig()
@@ -509,10 +443,22 @@ void AHBConfig::Reset()
     AHBBuyer                       = false;
 
     UseBuyPriceForBuyer            = false;
+    BuyerValueRanked               = false;
+    ReactiveBuyer                  = false;
+    ReactiveBuyerMinDelay          = 60;
+    ReactiveBuyerMaxDelay          = 600;
     UseBuyPriceForSeller           = false;
     SellAtMarketPrice              = false;
     ConsiderOnlyBotAuctions        = false;
     ItemsPerCycle                  = 200;
+    CountersCheckInterval          = 60;
+    PostingBatchSize               = 0;
+    SellerTimeBudget               = 0;
+    MaxPostsPerSecond              = 0;
+    MaxBidsPerSecond               = 0;
+    MaxBuyoutsPerSecond            = 0;
+    RateLimitBurst                 = 60;
+    RandomSeed                     = 0;
 
     Vendor_Items                   = false;
     Loot_Items                     = true;
@@ -574,11 +520,10 @@ void AHBConfig::Reset()
     // Sets
     //
 
-    NpcItems.clear();
-    LootItems.clear();
+    catalog.reset();
+    SellerWhiteList.reset();
 
-    DisableItemStore.clear();
-    SellerWhiteList.clear();
+    SellerWhiteListConfigured = false;
 
     GreyTradeGoodsBin.clear();
     WhiteTradeGoodsBin.clear();
@@ -599,6 +544,29 @@ void AHBConfig::Reset()
     itemsCount.clear();
     itemsSum.clear();
     itemsPrice.clear();
+
+    botItemsCount.clear();
+    botAuctionsCount.clear();
+    botCountersCheck               = time(NULL);
+    botCountersForced              = false;
+
+    botExpiries                    = {};
+    marketVersion                  = 0;
+    botRestockedVersion.clear();
+
+    playerAuctions.clear();
+    playerAuctionsIndex.clear();
+
+    reactiveQueue                  = {};
+    reactiveReady.clear();
+    reactiveShare                  = 0;
+
+    buyerValuation.clear();
+
+    valueRanking.clear();
+    valueRankingKey.clear();
+
+    depositCache.clear();
 }
 
 uint32 AHBConfig::GetAHID()
@@ -1974,1425 +1942,1743 @@ uint32 AHBConfig::GetItemCounts(uint32 color)
     }
 }
 
-void AHBConfig::SetBidsPerInterval(uint32 value)
+std::vector<AHBItemProfile> const& AHBConfig::GetBin(uint32 ahbotItemType)
 {
-    buyerBidsPerInterval = value;
+    static std::vector<AHBItemProfile> const emptyBin;
+
+    switch (ahbotItemType)
+    {
+    case AHB_GREY_TG:
+        return GreyTradeGoodsBin;
+
+    case AHB_WHITE_TG:
+        return WhiteTradeGoodsBin;
+
+    case AHB_GREEN_TG:
+        return GreenTradeGoodsBin;
+
+    case AHB_BLUE_TG:
+        return BlueTradeGoodsBin;
+
+    case AHB_PURPLE_TG:
+        return PurpleTradeGoodsBin;
+
+    case AHB_ORANGE_TG:
+        return OrangeTradeGoodsBin;
+
+    case AHB_YELLOW_TG:
+        return YellowTradeGoodsBin;
+
+    case AHB_GREY_I:
+        return GreyItemsBin;
+
+    case AHB_WHITE_I:
+        return WhiteItemsBin;
+
+    case AHB_GREEN_I:
+        return GreenItemsBin;
+
+    case AHB_BLUE_I:
+        return BlueItemsBin;
+
+    case AHB_PURPLE_I:
+        return PurpleItemsBin;
+
+    case AHB_ORANGE_I:
+        return OrangeItemsBin;
+
+    case AHB_YELLOW_I:
+        return YellowItemsBin;
+
+    default:
+        return emptyBin;
+    }
 }
 
-uint32 AHBConfig::GetBidsPerInterval()
+void AHBConfig::GetSellerParams(AHBSellerParams* params)
 {
-    return buyerBidsPerInterval;
+    for (uint32 quality = 0; quality <= AHB_MAX_QUALITY; ++quality)
+    {
+        params[quality].MinPrice    = GetMinPrice(quality);
+        params[quality].MaxPrice    = GetMaxPrice(quality);
+        params[quality].MinBidPrice = GetMinBidPrice(quality);
+        params[quality].MaxBidPrice = GetMaxBidPrice(quality);
+        params[quality].MaxStack    = GetMaxStack(quality);
+    }
 }
 
-void AHBConfig::UpdateItemStats(uint32 id, uint32 stackSize, uint64 buyout)
+void AHBConfig::IncBotItemCount(uint32 botId, uint32 itemId)
 {
-    if (!stackSize)
+    ++botItemsCount[(uint64(botId) << 32) | itemId];
+    ++botAuctionsCount[botId];
+}
+
+void AHBConfig::DecBotItemCount(uint32 botId, uint32 itemId)
+{
+    std::unordered_map<uint64, uint32>::iterator itr = botItemsCount.find((uint64(botId) << 32) | itemId);
+
+    if (itr == botItemsCount.end())
     {
         return;
     }
 
-    // 
-    // Collects information about the item bought
-    //
-
-    uint32 perUnit = buyout / stackSize;
-
-    if (itemsCount.count(id) == 0)
+    if (itr->second <= 1)
     {
-        itemsCount[id] = 1;
-        itemsSum[id]   = perUnit;
-        itemsPrice[id] = perUnit;
+        botItemsCount.erase(itr);
     }
     else
     {
-        itemsCount[id]++;
-
-        //
-        // Reset the statistics to force adapt to the market price.
-        // Adds a little of randomness by adding/removing a range of 9 to the threshold.
-        //
-
-        if (itemsCount[id] > MarketResetThreshold + (urand(1, 19) - 10))
-        {
-            itemsCount[id] = 1;
-            itemsSum[id]   = perUnit;
-            itemsPrice[id] = perUnit;
-        }
-        else
-        {
-            //
-            // Here is decided the price for single unit:
-            // right now is a plain, boring average of the ~100 previous auctions.
-            //
-
-            itemsSum[id]   = (itemsSum[id] + perUnit);
-            itemsPrice[id] = itemsSum[id] / itemsCount[id];
-        }
+        --itr->second;
     }
 
-    if (DebugOutConfig)
+    std::unordered_map<uint32, uint32>::iterator itb = botAuctionsCount.find(botId);
+
+    if (itb != botAuctionsCount.end() && itb->second > 0)
     {
-        LOG_INFO("module", "Updating market price item={}, price={}", id, itemsPrice[id]);
+        --itb->second;
     }
 }
 
-uint64 AHBConfig::GetItemPrice(uint32 id)
+uint32 AHBConfig::GetBotItemCount(uint32 botId, uint32 itemId)
 {
-    if (itemsCount.count(id) != 0)
+    std::unordered_map<uint64, uint32>::const_iterator itr = botItemsCount.find((uint64(botId) << 32) | itemId);
+
+    if (itr == botItemsCount.end())
     {
-        return itemsPrice[id];
+        return 0;
     }
 
-    return 0;
+    return itr->second;
 }
 
-void AHBConfig::Initialize(std::set<uint32> botsIds)
+uint32 AHBConfig::GetBotAuctionCount(uint32 botId)
 {
-    InitializeFromFile();
-    InitializeFromSql(botsIds);
-    InitializeBins();
+    std::unordered_map<uint32, uint32>::const_iterator itr = botAuctionsCount.find(botId);
+
+    if (itr == botAuctionsCount.end())
+    {
+        return 0;
+    }
+
+    return itr->second;
 }
 
-void AHBConfig::InitializeFromFile()
+void AHBConfig::ResetBotItemCounts()
 {
-    //
-    // Load from, the configuration file
-    //
+    botItemsCount.clear();
+    botAuctionsCount.clear();
 
-    DebugOut                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG"        , false);
-    DebugOutConfig                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_CONFIG" , false);
-    DebugOutFilters                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_FILTERS", false);
-    DebugOutBuyer                  = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_BUYER"  , false);
-    DebugOutSeller                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_SELLER" , false);
+    botCountersCheck = time(NULL);
 
-    TraceSeller                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.TRACE_SELLER" , false);
-    TraceBuyer                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.TRACE_BUYER"  , false);
+    MarkMarketChanged();
+}
 
-    AHBSeller                      = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.EnableSeller"           , false);
-    AHBBuyer                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.EnableBuyer"            , false);
-    UseBuyPriceForSeller           = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseBuyPriceForSeller"   , false);
-    UseBuyPriceForBuyer            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseBuyPriceForBuyer"    , false);
-    SellAtMarketPrice              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseMarketPriceForSeller", false);
-    MarketResetThreshold           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.MarketResetThreshold"   , 25);
-    DuplicatesCount                = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DuplicatesCount"        , 0);
-    DivisibleStacks                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DivisibleStacks"        , false);
-    ElapsingTimeClass              = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ElapsingTimeClass"      , 1);
-    ConsiderOnlyBotAuctions        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.ConsiderOnlyBotAuctions", false);
-    ItemsPerCycle                  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ItemsPerCycle"          , 200);
+void AHBConfig::ScanBotAuctions(std::set<uint32> const& botsIds, std::unordered_map<uint64, uint32>& itemsCount, std::unordered_map<uint32, uint32>& auctionsCount)
+{
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
 
-    //
-    // Flags: item types
-    //
+    for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
+    {
+        AuctionEntry* Aentry = itr->second;
 
-    Vendor_Items                   = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.VendorItems"      , false);
-    Loot_Items                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.LootItems"        , true);
-    Other_Items                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.OtherItems"       , false);
-    Vendor_TGs                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.VendorTradeGoods" , false);
-    Loot_TGs                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.LootTradeGoods"   , true);
-    Other_TGs                      = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.OtherTradeGoods"  , false);
-    Profession_Items               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.ProfessionItems"  , false);
+        if (botsIds.find(Aentry->owner.GetCounter()) != botsIds.end())
+        {
+            ++itemsCount[(uint64(Aentry->owner.GetCounter()) << 32) | Aentry->item_template];
+            ++auctionsCount[Aentry->owner.GetCounter()];
+        }
+    }
+}
 
+void AHBConfig::CheckBotCounters()
+{
     //
-    // Flags: items binding
+    // The counters are maintained by the auction house hooks; once in a while compare them with the real content of the market
     //
 
-    No_Bind                        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.No_Bind"             , true);
-    Bind_When_Picked_Up            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Picked_Up" , false);
-    Bind_When_Equipped             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Equipped"  , true);
-    Bind_When_Use                  = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Use"       , true);
-    Bind_Quest_Item                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_Quest_Item"     , false);
+    time_t now = time(NULL);
 
-    //
-    // Flags: misc
-    //
+    if (!botCountersForced)
+    {
+        if (CountersCheckInterval == 0)
+        {
+            return;
+        }
 
-    DisableConjured                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableConjured"               , false);
-    DisableGems                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableGems"                   , false);
-    DisableMoney                   = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMoney"                  , false);
-    DisableMoneyLoot               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMoneyLoot"              , false);
-    DisableLootable                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableLootable"               , false);
-    DisableKeys                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableKeys"                   , false);
-    DisableDuration                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDuration"               , false);
-    DisableBOP_Or_Quest_NoReqLevel = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableBOP_Or_Quest_NoReqLevel", false);
+        if ((now - botCountersCheck) < time_t(CountersCheckInterval * MINUTE))
+        {
+            return;
+        }
+    }
 
-    //
-    // Flags: items per class
-    //
+    botCountersCheck  = now;
+    botCountersForced = false;
 
-    DisableWarriorItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableWarriorItems"    , false);
-    DisablePaladinItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisablePaladinItems"    , false);
-    DisableHunterItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableHunterItems"     , false);
-    DisableRogueItems              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableRogueItems"      , false);
-    DisablePriestItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisablePriestItems"     , false);
-    DisableDKItems                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDKItems"         , false);
-    DisableShamanItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableShamanItems"     , false);
-    DisableMageItems               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMageItems"       , false);
-    DisableWarlockItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableWarlockItems"    , false);
-    DisableUnusedClassItems        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableUnusedClassItems", false);
-    DisableDruidItems              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDruidItems"      , false);
+    std::unordered_map<uint64, uint32> itemsCount;
+    std::unordered_map<uint32, uint32> auctionsCount;
 
-    //
-    // Items level and skills
-    //
+    ScanBotAuctions(gBotsId, itemsCount, auctionsCount);
 
-    DisableItemsBelowLevel         = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowLevel"       , 0);
-    DisableItemsAboveLevel         = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveLevel"       , 0);
-    DisableItemsBelowGUID          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowGUID"        , 0);
-    DisableItemsAboveGUID          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveGUID"        , 0);
-    DisableItemsBelowReqLevel      = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowReqLevel"    , 0);
-    DisableItemsAboveReqLevel      = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveReqLevel"    , 0);
-    DisableItemsBelowReqSkillRank  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowReqSkillRank", 0);
-    DisableItemsAboveReqSkillRank  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveReqSkillRank", 0);
+    bool drift = false;
 
-    //
-    // Trade goods level and skills
-    //
+    for (uint32 botId : gBotsId)
+    {
+        uint32 counted = auctionsCount.count(botId) ? auctionsCount[botId] : 0;
 
-    DisableTGsBelowLevel           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowLevel"       , 0);
-    DisableTGsAboveLevel           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveLevel"       , 0);
-    DisableTGsBelowGUID            = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowGUID"        , 0);
-    DisableTGsAboveGUID            = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveGUID"        , 0);
-    DisableTGsBelowReqLevel        = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowReqLevel"    , 0);
-    DisableTGsAboveReqLevel        = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveReqLevel"    , 0);
-    DisableTGsBelowReqSkillRank    = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowReqSkillRank", 0);
-    DisableTGsAboveReqSkillRank    = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveReqSkillRank", 0);
+        if (counted != GetBotAuctionCount(botId))
+        {
+            LOG_ERROR("module", "AHBot [{}]: auctions counter drift for ah {}, tracked={} real={}", botId, GetAHID(), GetBotAuctionCount(botId), counted);
 
-    //
-    // Whitelists
-    //
+            drift = true;
+        }
+    }
 
-    SellerWhiteList                = getCommaSeparatedIntegers(sConfigMgr->GetOption<std::string>("AuctionHouseBot.SellerWhiteList", ""));
+    botItemsCount.swap(itemsCount);
+    botAuctionsCount.swap(auctionsCount);
+
+    if (drift)
+    {
+        MarkMarketChanged();
+    }
 }
 
-void AHBConfig::InitializeFromSql(std::set<uint32> botsIds)
+void AHBConfig::ScanPlayerAuctions(std::set<uint32> const& botsIds)
 {
-    //
-    // Load min and max items
-    //
+    playerAuctions.clear();
+    playerAuctionsIndex.clear();
+
+    valueRanking.clear();
+    valueRankingKey.clear();
+
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
+
+    for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
+    {
+        if (botsIds.find(itr->second->owner.GetCounter()) == botsIds.end())
+        {
+            AddPlayerAuction(itr->second);
+        }
+    }
+}
+
+void AHBConfig::AddPlayerAuction(AuctionEntry const* auction)
+{
+    if (playerAuctionsIndex.find(auction->Id) != playerAuctionsIndex.end())
+    {
+        return;
+    }
+
+    playerAuctionsIndex[auction->Id] = playerAuctions.size();
+    playerAuctions.push_back(auction->Id);
+
+    UpdateAuctionValue(auction, auction->bid ? auction->bid : auction->startbid);
+}
+
+void AHBConfig::RemovePlayerAuction(uint32 auctionId)
+{
+    std::unordered_map<uint32, uint32>::iterator itr = playerAuctionsIndex.find(auctionId);
 
-    SetMinItems(WorldDatabase.Query("SELECT minitems FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxItems(WorldDatabase.Query("SELECT maxitems FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+    if (itr == playerAuctionsIndex.end())
+    {
+        return;
+    }
 
     //
-    // Load percentages
+    // Move the last element in the hole to keep the vector packed
     //
 
-    uint32 greytg   = WorldDatabase.Query("SELECT percentgreytradegoods   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 whitetg  = WorldDatabase.Query("SELECT percentwhitetradegoods  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 greentg  = WorldDatabase.Query("SELECT percentgreentradegoods  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 bluetg   = WorldDatabase.Query("SELECT percentbluetradegoods   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 purpletg = WorldDatabase.Query("SELECT percentpurpletradegoods FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 orangetg = WorldDatabase.Query("SELECT percentorangetradegoods FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 yellowtg = WorldDatabase.Query("SELECT percentyellowtradegoods FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
+    uint32 position = itr->second;
+    uint32 last     = playerAuctions.back();
 
-    uint32 greyi    = WorldDatabase.Query("SELECT percentgreyitems        FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 whitei   = WorldDatabase.Query("SELECT percentwhiteitems       FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 greeni   = WorldDatabase.Query("SELECT percentgreenitems       FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 bluei    = WorldDatabase.Query("SELECT percentblueitems        FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 purplei  = WorldDatabase.Query("SELECT percentpurpleitems      FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 orangei  = WorldDatabase.Query("SELECT percentorangeitems      FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
-    uint32 yellowi  = WorldDatabase.Query("SELECT percentyellowitems      FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>();
+    playerAuctions[position]  = last;
+    playerAuctionsIndex[last] = position;
 
-    SetPercentages(greytg, whitetg, greentg, bluetg, purpletg, orangetg, yellowtg, greyi, whitei, greeni, bluei, purplei, orangei, yellowi);
+    playerAuctions.pop_back();
+    playerAuctionsIndex.erase(auctionId);
 
-    // 
-    // Load min and max prices
-    // 
+    SetAuctionValue(auctionId, 0.0);
+}
 
-    SetMinPrice(AHB_GREY  , WorldDatabase.Query("SELECT minpricegrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_GREY  , WorldDatabase.Query("SELECT maxpricegrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_WHITE , WorldDatabase.Query("SELECT minpricewhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_WHITE , WorldDatabase.Query("SELECT maxpricewhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_GREEN , WorldDatabase.Query("SELECT minpricegreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_GREEN , WorldDatabase.Query("SELECT maxpricegreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_BLUE  , WorldDatabase.Query("SELECT minpriceblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_BLUE  , WorldDatabase.Query("SELECT maxpriceblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_PURPLE, WorldDatabase.Query("SELECT minpricepurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_PURPLE, WorldDatabase.Query("SELECT maxpricepurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_ORANGE, WorldDatabase.Query("SELECT minpriceorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_ORANGE, WorldDatabase.Query("SELECT maxpriceorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinPrice(AHB_YELLOW, WorldDatabase.Query("SELECT minpriceyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxPrice(AHB_YELLOW, WorldDatabase.Query("SELECT maxpriceyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+uint32 AHBConfig::GetPlayerAuctionsCount()
+{
+    return playerAuctions.size();
+}
 
-    // 
-    // Load min and max bid prices
-    // 
+void AHBConfig::SamplePlayerAuctions(uint32 botId, AHBRandom& random, uint32 count, std::vector<uint32>& sample)
+{
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
 
-    SetMinBidPrice(AHB_GREY  , WorldDatabase.Query("SELECT minbidpricegrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_GREY  , WorldDatabase.Query("SELECT maxbidpricegrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_WHITE , WorldDatabase.Query("SELECT minbidpricewhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_WHITE , WorldDatabase.Query("SELECT maxbidpricewhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_GREEN , WorldDatabase.Query("SELECT minbidpricegreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_GREEN , WorldDatabase.Query("SELECT maxbidpricegreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_BLUE  , WorldDatabase.Query("SELECT minbidpriceblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_BLUE  , WorldDatabase.Query("SELECT maxbidpriceblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_PURPLE, WorldDatabase.Query("SELECT minbidpricepurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_PURPLE, WorldDatabase.Query("SELECT maxbidpricepurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_ORANGE, WorldDatabase.Query("SELECT minbidpriceorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_ORANGE, WorldDatabase.Query("SELECT maxbidpriceorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMinBidPrice(AHB_YELLOW, WorldDatabase.Query("SELECT minbidpriceyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxBidPrice(AHB_YELLOW, WorldDatabase.Query("SELECT maxbidpriceyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+    //
+    // Partial Fisher-Yates: the first slots are shuffled in place, the order of the set is not relevant.
+    // The auctions where the bot already holds the highest bid are drawn but not kept, so that every
+    // pick is an auction the bot can actually bid on.
+    //
 
-    // 
-    // Load max stacks
-    // 
+    uint32 size = playerAuctions.size();
 
-    SetMaxStack(AHB_GREY  , WorldDatabase.Query("SELECT maxstackgrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_WHITE , WorldDatabase.Query("SELECT maxstackwhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_GREEN , WorldDatabase.Query("SELECT maxstackgreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_BLUE  , WorldDatabase.Query("SELECT maxstackblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_PURPLE, WorldDatabase.Query("SELECT maxstackpurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_ORANGE, WorldDatabase.Query("SELECT maxstackorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetMaxStack(AHB_YELLOW, WorldDatabase.Query("SELECT maxstackyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+    sample.clear();
+    sample.reserve(count < size ? count : size);
 
-    if (DebugOutConfig)
+    for (uint32 i = 0; i < size && sample.size() < count; ++i)
     {
-        LOG_INFO("module", "Settings for Auctionhouse {}", GetAHID());
+        uint32 j = random.Range(i, size - 1);
 
-        LOG_INFO("module", "minItems                = {}", GetMinItems());
-        LOG_INFO("module", "maxItems                = {}", GetMaxItems());
+        std::swap(playerAuctions[i], playerAuctions[j]);
 
-        LOG_INFO("module", "percentGreyTradeGoods   = {}", GetPercentages(AHB_GREY_TG));
-        LOG_INFO("module", "percentWhiteTradeGoods  = {}", GetPercentages(AHB_WHITE_TG));
-        LOG_INFO("module", "percentGreenTradeGoods  = {}", GetPercentages(AHB_GREEN_TG));
-        LOG_INFO("module", "percentBlueTradeGoods   = {}", GetPercentages(AHB_BLUE_TG));
-        LOG_INFO("module", "percentPurpleTradeGoods = {}", GetPercentages(AHB_PURPLE_TG));
-        LOG_INFO("module", "percentOrangeTradeGoods = {}", GetPercentages(AHB_ORANGE_TG));
-        LOG_INFO("module", "percentYellowTradeGoods = {}", GetPercentages(AHB_YELLOW_TG));
-        LOG_INFO("module", "percentGreyItems        = {}", GetPercentages(AHB_GREY_I));
-        LOG_INFO("module", "percentWhiteItems       = {}", GetPercentages(AHB_WHITE_I));
-        LOG_INFO("module", "percentGreenItems       = {}", GetPercentages(AHB_GREEN_I));
-        LOG_INFO("module", "percentBlueItems        = {}", GetPercentages(AHB_BLUE_I));
-        LOG_INFO("module", "percentPurpleItems      = {}", GetPercentages(AHB_PURPLE_I));
-        LOG_INFO("module", "percentOrangeItems      = {}", GetPercentages(AHB_ORANGE_I));
-        LOG_INFO("module", "percentYellowItems      = {}", GetPercentages(AHB_YELLOW_I));
+        playerAuctionsIndex[playerAuctions[i]] = i;
+        playerAuctionsIndex[playerAuctions[j]] = j;
 
-        LOG_INFO("module", "minPriceGrey            = {}", GetMinPrice(AHB_GREY));
-        LOG_INFO("module", "maxPriceGrey            = {}", GetMaxPrice(AHB_GREY));
-        LOG_INFO("module", "minPriceWhite           = {}", GetMinPrice(AHB_WHITE));
-        LOG_INFO("module", "maxPriceWhite           = {}", GetMaxPrice(AHB_WHITE));
-        LOG_INFO("module", "minPriceGreen           = {}", GetMinPrice(AHB_GREEN));
-        LOG_INFO("module", "maxPriceGreen           = {}", GetMaxPrice(AHB_GREEN));
-        LOG_INFO("module", "minPriceBlue            = {}", GetMinPrice(AHB_BLUE));
-        LOG_INFO("module", "maxPriceBlue            = {}", GetMaxPrice(AHB_BLUE));
-        LOG_INFO("module", "minPricePurple          = {}", GetMinPrice(AHB_PURPLE));
-        LOG_INFO("module", "maxPricePurple          = {}", GetMaxPrice(AHB_PURPLE));
-        LOG_INFO("module", "minPriceOrange          = {}", GetMinPrice(AHB_ORANGE));
-        LOG_INFO("module", "maxPriceOrange          = {}", GetMaxPrice(AHB_ORANGE));
-        LOG_INFO("module", "minPriceYellow          = {}", GetMinPrice(AHB_YELLOW));
-        LOG_INFO("module", "maxPriceYellow          = {}", GetMaxPrice(AHB_YELLOW));
+        AuctionEntry* auction = auctionHouse->GetAuction(playerAuctions[i]);
 
-        LOG_INFO("module", "minBidPriceGrey         = {}", GetMinBidPrice(AHB_GREY));
-        LOG_INFO("module", "maxBidPriceGrey         = {}", GetMaxBidPrice(AHB_GREY));
-        LOG_INFO("module", "minBidPriceWhite        = {}", GetMinBidPrice(AHB_WHITE));
-        LOG_INFO("module", "maxBidPriceWhite        = {}", GetMaxBidPrice(AHB_WHITE));
-        LOG_INFO("module", "minBidPriceGreen        = {}", GetMinBidPrice(AHB_GREEN));
-        LOG_INFO("module", "maxBidPriceGreen        = {}", GetMaxBidPrice(AHB_GREEN));
-        LOG_INFO("module", "minBidPriceBlue         = {}", GetMinBidPrice(AHB_BLUE));
-        LOG_INFO("module", "maxBidPriceBlue         = {}", GetMinBidPrice(AHB_BLUE));
-        LOG_INFO("module", "minBidPricePurple       = {}", GetMinBidPrice(AHB_PURPLE));
-        LOG_INFO("module", "maxBidPricePurple       = {}", GetMaxBidPrice(AHB_PURPLE));
-        LOG_INFO("module", "minBidPriceOrange       = {}", GetMinBidPrice(AHB_ORANGE));
-        LOG_INFO("module", "maxBidPriceOrange       = {}", GetMaxBidPrice(AHB_ORANGE));
-        LOG_INFO("module", "minBidPriceYellow       = {}", GetMinBidPrice(AHB_YELLOW));
-        LOG_INFO("module", "maxBidPriceYellow       = {}", GetMaxBidPrice(AHB_YELLOW));
+        if (auction && auction->bidder.GetCounter() == botId)
+        {
+            continue;
+        }
 
-        LOG_INFO("module", "maxStackGrey            = {}", GetMaxStack(AHB_GREY));
-        LOG_INFO("module", "maxStackWhite           = {}", GetMaxStack(AHB_WHITE));
-        LOG_INFO("module", "maxStackGreen           = {}", GetMaxStack(AHB_GREEN));
-        LOG_INFO("module", "maxStackBlue            = {}", GetMaxStack(AHB_BLUE));
-        LOG_INFO("module", "maxStackPurple          = {}", GetMaxStack(AHB_PURPLE));
-        LOG_INFO("module", "maxStackOrange          = {}", GetMaxStack(AHB_ORANGE));
-        LOG_INFO("module", "maxStackYellow          = {}", GetMaxStack(AHB_YELLOW));
+        sample.push_back(playerAuctions[i]);
     }
+}
 
-    //
-    // Reset the situation of the auction house
-    //
+void AHBConfig::QueueReactiveAuction(uint32 auctionId)
+{
+    if (!ReactiveBuyer)
+    {
+        return;
+    }
 
-    ResetItemCounts();
+    reactiveQueue.push(std::make_pair(time(NULL) + random.Range(ReactiveBuyerMinDelay, ReactiveBuyerMaxDelay), auctionId));
+}
+
+void AHBConfig::PopDueReactiveAuctions(std::vector<uint32>& due)
+{
+    time_t now = time(NULL);
+
+    due.clear();
 
     //
-    // Update the situation of the auction house
+    // Every bot takes its slice of the auctions that became due, otherwise the first bot updated
+    // would react to all of them. The slice is sized when new auctions become due, so that all
+    // the bots get the same amount in the same tick.
     //
 
-    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
-    uint32 numberOfAuctions = auctionHouse->Getcount();
+    bool added = false;
 
-    if (numberOfAuctions > 0)
+    while (!reactiveQueue.empty() && reactiveQueue.top().first <= now)
     {
-        for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
-        {
-            AuctionEntry* Aentry = itr->second;
-            Item*         item   = sAuctionMgr->GetAItem(Aentry->item_guid);
-
-            //
-            // If it has to only consider the bots auctions, skip the ones belonging to the players
-            //
+        reactiveReady.push_back(reactiveQueue.top().second);
+        reactiveQueue.pop();
 
-            if (ConsiderOnlyBotAuctions)
-            {
-                if (botsIds.find(Aentry->owner.GetCounter()) == botsIds.end())
-                {
-                    continue;
-                }
-            }
+        added = true;
+    }
 
-            if (item)
-            {
-                ItemTemplate const* prototype = item->GetTemplate();
+    if (added)
+    {
+        uint32 nbBots = std::max<uint32>(1, gBotsId.size());
 
-                if (prototype)
-                {
-                    switch (prototype->Quality)
-                    {
-                    case AHB_GREY:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_GREY_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_GREY_I);
-                        }
-                        break;
+        reactiveShare = (reactiveReady.size() + nbBots - 1) / nbBots;
+    }
 
-                    case AHB_WHITE:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_WHITE_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_WHITE_I);
-                        }
+    uint32 count = std::min<uint32>(reactiveShare, reactiveReady.size());
 
-                        break;
+    due.assign(reactiveReady.end() - count, reactiveReady.end());
+    reactiveReady.resize(reactiveReady.size() - count);
+}
 
-                    case AHB_GREEN:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_GREEN_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_GREEN_I);
-                        }
+bool AHBConfig::HasDueReactiveAuctions()
+{
+    return !reactiveReady.empty() || (!reactiveQueue.empty() && reactiveQueue.top().first <= time(NULL));
+}
 
-                        break;
+void AHBConfig::BuildBuyerValuation()
+{
+    ItemTemplateContainer const* its = sObjectMgr->GetItemTemplateStore();
 
-                    case AHB_BLUE:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_BLUE_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_BLUE_I);
-                        }
+    uint32 maxId = 0;
 
-                        break;
+    for (ItemTemplateContainer::const_iterator itr = its->begin(); itr != its->end(); ++itr)
+    {
+        maxId = std::max(maxId, itr->second.ItemId);
+    }
 
-                    case AHB_PURPLE:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_PURPLE_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_PURPLE_I);
-                        }
+    buyerValuation.assign(maxId + 1, 0);
 
-                        break;
+    for (ItemTemplateContainer::const_iterator itr = its->begin(); itr != its->end(); ++itr)
+    {
+        //
+        // Some classes of items are never bought
+        //
 
-                    case AHB_ORANGE:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_ORANGE_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_ORANGE_I);
-                        }
+        switch (itr->second.Class)
+        {
+        case ITEM_CLASS_PROJECTILE:
+        case ITEM_CLASS_GENERIC:
+        case ITEM_CLASS_MONEY:
+        case ITEM_CLASS_PERMANENT:
+            continue;
 
-                        break;
+        default:
+            break;
+        }
 
-                    case AHB_YELLOW:
-                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
-                        {
-                            IncItemCounts(AHB_YELLOW_TG);
-                        }
-                        else
-                        {
-                            IncItemCounts(AHB_YELLOW_I);
-                        }
+        uint64 basePrice = UseBuyPriceForBuyer ? itr->second.BuyPrice : itr->second.SellPrice;
 
-                        break;
-                    }
-                }
-            }
-        }
+        buyerValuation[itr->second.ItemId] = basePrice * GetBuyerPrice(itr->second.Quality);
     }
+}
 
-    if (DebugOutConfig)
+uint64 AHBConfig::GetBuyerValuation(uint32 itemId)
+{
+    if (itemId >= buyerValuation.size())
     {
-        LOG_INFO("module", "Current situation for the auctionhouse {}", GetAHID());
-        LOG_INFO("module", "    Grey   Trade Goods {}", GetItemCounts(AHB_GREY_TG));
-        LOG_INFO("module", "    White  Trade Goods {}", GetItemCounts(AHB_WHITE_TG));
-        LOG_INFO("module", "    Green  Trade Goods {}", GetItemCounts(AHB_GREEN_TG));
-        LOG_INFO("module", "    Blue   Trade Goods {}", GetItemCounts(AHB_BLUE_TG));
-        LOG_INFO("module", "    Purple Trade Goods {}", GetItemCounts(AHB_PURPLE_TG));
-        LOG_INFO("module", "    Orange Trade Goods {}", GetItemCounts(AHB_ORANGE_TG));
-        LOG_INFO("module", "    Yellow Trade Goods {}", GetItemCounts(AHB_YELLOW_TG));
-        LOG_INFO("module", "    Grey   Items       {}", GetItemCounts(AHB_GREY_I));
-        LOG_INFO("module", "    White  Items       {}", GetItemCounts(AHB_WHITE_I));
-        LOG_INFO("module", "    Green  Items       {}", GetItemCounts(AHB_GREEN_I));
-        LOG_INFO("module", "    Blue   Items       {}", GetItemCounts(AHB_BLUE_I));
-        LOG_INFO("module", "    Purple Items       {}", GetItemCounts(AHB_PURPLE_I));
-        LOG_INFO("module", "    Orange Items       {}", GetItemCounts(AHB_ORANGE_I));
-        LOG_INFO("module", "    Yellow Items       {}", GetItemCounts(AHB_YELLOW_I));
+        return 0;
     }
 
-    //
-    // Auctions buyer
-    //
-
-    SetBuyerPrice(AHB_GREY  , WorldDatabase.Query("SELECT buyerpricegrey   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_WHITE , WorldDatabase.Query("SELECT buyerpricewhite  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_GREEN , WorldDatabase.Query("SELECT buyerpricegreen  FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_BLUE  , WorldDatabase.Query("SELECT buyerpriceblue   FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_PURPLE, WorldDatabase.Query("SELECT buyerpricepurple FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_ORANGE, WorldDatabase.Query("SELECT buyerpriceorange FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-    SetBuyerPrice(AHB_YELLOW, WorldDatabase.Query("SELECT buyerpriceyellow FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
-
-    //
-    // Load bidding interval
-    //
+    return buyerValuation[itemId];
+}
 
-    SetBiddingInterval(WorldDatabase.Query("SELECT buyerbiddinginterval FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+double AHBConfig::GetAuctionValue(AuctionEntry const* auction, uint32 currentPrice)
+{
+    double maximumBid = double(GetBuyerValuation(auction->item_template)) * auction->itemCount;
 
-    //
-    // Load bids per interval
-    //
+    return maximumBid / (currentPrice > 0 ? currentPrice : 1);
+}
 
-    SetBidsPerInterval(WorldDatabase.Query("SELECT buyerbidsperinterval FROM mod_auctionhousebot WHERE auctionhouse = {}", GetAHID())->Fetch()->Get<uint32>());
+void AHBConfig::SetAuctionValue(uint32 auctionId, double value)
+{
+    std::unordered_map<uint32, double>::iterator itr = valueRankingKey.find(auctionId);
 
-    if (DebugOutConfig)
+    if (itr != valueRankingKey.end())
     {
-        LOG_INFO("module", "Current Settings for Auctionhouse {} buyer", GetAHID());
-        LOG_INFO("module", "buyerPriceGrey          = {}", GetBuyerPrice(AHB_GREY));
-        LOG_INFO("module", "buyerPriceWhite         = {}", GetBuyerPrice(AHB_WHITE));
-        LOG_INFO("module", "buyerPriceGreen         = {}", GetBuyerPrice(AHB_GREEN));
-        LOG_INFO("module", "buyerPriceBlue          = {}", GetBuyerPrice(AHB_BLUE));
-        LOG_INFO("module", "buyerPricePurple        = {}", GetBuyerPrice(AHB_PURPLE));
-        LOG_INFO("module", "buyerPriceOrange        = {}", GetBuyerPrice(AHB_ORANGE));
-        LOG_INFO("module", "buyerPriceYellow        = {}", GetBuyerPrice(AHB_YELLOW));
-        LOG_INFO("module", "buyerBiddingInterval    = {}", GetBiddingInterval());
-        LOG_INFO("module", "buyerBidsPerInterval    = {}", GetBidsPerInterval());
+        valueRanking.erase(std::make_pair(itr->second, auctionId));
+        valueRankingKey.erase(itr);
     }
 
     //
-    // Reload the list of disabled items
+    // Auctions that will never be bought are not ranked at all
     //
 
-    DisableItemStore.clear();
-
-    QueryResult result = WorldDatabase.Query("SELECT item FROM mod_auctionhousebot_disabled_items");
-
-    if (result)
-    {
-        do
-        {
-            Field* fields = result->Fetch();
-            DisableItemStore.insert(fields[0].Get<uint32>());
-        } while (result->NextRow());
-    }
-
-    if (DebugOutConfig)
-    {
-        LOG_INFO("module", "Loaded {} items from the disabled item store", uint32(DisableItemStore.size()));
-    }
-
-    // 
-    // Reload the list of npc items
-    // 
-
-    NpcItems.clear();
-
-    QueryResult npcResults = WorldDatabase.Query("SELECT distinct item FROM npc_vendor");
-
-    if (npcResults)
-    {
-        do
-        {
-            Field* fields = npcResults->Fetch();
-            NpcItems.insert(fields[0].Get<int32>());
-
-        } while (npcResults->NextRow());
-    }
-    else
+    if (value > 0.0)
     {
-        if (DebugOutConfig)
-        {
-            LOG_ERROR("module", "AuctionHouseBot: failed to retrieve npc items");
-        }
+        valueRanking.insert(std::make_pair(value, auctionId));
+        valueRankingKey[auctionId] = value;
     }
+}
 
-    if (DebugOutConfig)
+void AHBConfig::UpdateAuctionValue(AuctionEntry const* auction, uint32 currentPrice)
+{
+    if (!BuyerValueRanked || playerAuctionsIndex.find(auction->Id) == playerAuctionsIndex.end())
     {
-        LOG_INFO("module", "Loaded {} items from NPCs", uint32(NpcItems.size()));
+        return;
     }
 
-    // 
-    // Reload the list from the lootable items
-    // 
-
-    LootItems.clear();
-
-    QueryResult itemsResults = WorldDatabase.Query(
-        "SELECT item FROM creature_loot_template      UNION "
-        "SELECT item FROM reference_loot_template     UNION "
-        "SELECT item FROM disenchant_loot_template    UNION "
-        "SELECT item FROM fishing_loot_template       UNION "
-        "SELECT item FROM gameobject_loot_template    UNION "
-        "SELECT item FROM item_loot_template          UNION "
-        "SELECT item FROM milling_loot_template       UNION "
-        "SELECT item FROM pickpocketing_loot_template UNION "
-        "SELECT item FROM prospecting_loot_template   UNION "
-        "SELECT item FROM skinning_loot_template");
+    SetAuctionValue(auction->Id, GetAuctionValue(auction, currentPrice));
+}
 
-    if (itemsResults)
-    {
-        do
-        {
-            Field* fields = itemsResults->Fetch();
-            LootItems.insert(fields[0].Get<uint32>());
+void AHBConfig::RebuildValueRanking()
+{
+    valueRanking.clear();
+    valueRankingKey.clear();
 
-        } while (itemsResults->NextRow());
-    }
-    else
+    if (!BuyerValueRanked)
     {
-        if (DebugOutConfig)
-        {
-            LOG_ERROR("module", "AuctionHouseBot: failed to retrieve loot items");
-        }
+        return;
     }
 
-    //
-    // Include profession items
-    //
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
 
-    if (Profession_Items)
+    for (uint32 auctionId : playerAuctions)
     {
-        itemsResults = WorldDatabase.Query(
-            "SELECT item FROM auctionhousebot_professionItems");
+        AuctionEntry* auction = auctionHouse->GetAuction(auctionId);
 
-        if (itemsResults)
+        if (auction)
         {
-            do
-            {
-                Field* fields = itemsResults->Fetch();
-                uint32 item   = fields[0].Get<uint32>();
-                
-                if(LootItems.find(item) == LootItems.end())
-                {
-                    LootItems.insert(fields[0].Get<uint32>());
-                }
-            } while (itemsResults->NextRow());
+            SetAuctionValue(auctionId, GetAuctionValue(auction, auction->bid ? auction->bid : auction->startbid));
         }
     }
-
-    if (DebugOutConfig)
-    {
-        LOG_INFO("module", "Loaded {} items from lootable items", uint32(LootItems.size()));
-    }
 }
 
-void AHBConfig::InitializeBins()
+void AHBConfig::SelectValuableAuctions(uint32 botId, uint32 count, std::vector<uint32>& sample)
 {
-    //
-    // Exclude items depending on the configuration; whatever passes all the tests is put in the lists.
-    //
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
 
-    ItemTemplateContainer const* its = sObjectMgr->GetItemTemplateStore();
+    std::vector<std::pair<double, uint32>> taken;
 
-    for (ItemTemplateContainer::const_iterator itr = its->begin(); itr != its->end(); ++itr)
+    sample.clear();
+
+    while (sample.size() < count && !valueRanking.empty())
     {
+        std::pair<double, uint32> best = *valueRanking.begin();
 
-        //
-        // Exclude items with the blocked binding type
-        //
+        valueRanking.erase(valueRanking.begin());
+        valueRankingKey.erase(best.second);
 
-        if (itr->second.Bonding == NO_BIND && !No_Bind)
-        {
-            continue;
-        }
+        AuctionEntry* auction = auctionHouse->GetAuction(best.second);
 
-        if (itr->second.Bonding == BIND_WHEN_PICKED_UP && !Bind_When_Picked_Up)
+        if (!auction)
         {
             continue;
         }
 
-        if (itr->second.Bonding == BIND_WHEN_EQUIPPED && !Bind_When_Equipped)
-        {
-            continue;
-        }
+        //
+        // Every change of price re-keys the auction: the bids through the hooks, the bids given back
+        // by a failed write through UndoWrites, the buyer prices through a rebuild of the ranking.
+        // A key found too optimistic anyway is put back with its real value, and the top looked at again.
+        //
 
-        if (itr->second.Bonding == BIND_WHEN_USE && !Bind_When_Use)
-        {
-            continue;
-        }
+        double value = GetAuctionValue(auction, auction->bid ? auction->bid : auction->startbid);
 
-        if (itr->second.Bonding == BIND_QUEST_ITEM && !Bind_Quest_Item)
+        if (value < best.first)
         {
+            SetAuctionValue(best.second, value);
             continue;
         }
 
+        taken.push_back(std::make_pair(value, best.second));
+
         //
-        // Exclude items with no possible price
+        // Nothing is worth buying below the top one
         //
 
-        if (UseBuyPriceForSeller)
-        {
-            if (itr->second.BuyPrice == 0)
-            {
-                continue;
-            }
-        }
-        else
+        if (value < 1.0)
         {
-            if (itr->second.SellPrice == 0)
-            {
-                continue;
-            }
+            break;
         }
 
         //
-        // Exclude items with no costs associated, in any case
+        // The bot already holds the highest bid on this one
         //
 
-        if ((itr->second.BuyPrice == 0) && (itr->second.SellPrice == 0))
+        if (auction->bidder.GetCounter() == botId)
         {
             continue;
         }
 
-        //
-        // Exlude items superior to the limit quality
-        //
+        sample.push_back(best.second);
+    }
 
-        if (itr->second.Quality > 6)
-        {
-            continue;
-        }
+    for (std::pair<double, uint32> const& entry : taken)
+    {
+        SetAuctionValue(entry.second, entry.first);
+    }
+}
 
-        //
-        // Exclude trade goods items
-        //
+void AHBConfig::ForceBotCountersCheck()
+{
+    //
+    // The next check will run at the next seller cycle whatever the interval, the market is considered changed meanwhile
+    //
 
-        if (itr->second.Class == ITEM_CLASS_TRADE_GOODS)
-        {
-            bool isNpc   = false;
-            bool isLoot  = false;
-            bool exclude = false;
+    botCountersForced = true;
 
-            if (NpcItems.find(itr->second.ItemId) != NpcItems.end())
-            {
-                isNpc = true;
+    MarkMarketChanged();
+}
 
-                if (!Vendor_TGs)
-                {
-                    exclude = true;
-                }
-            }
+void AHBConfig::ScheduleExpiry(time_t expireTime)
+{
+    botExpiries.push(expireTime);
+}
 
-            if (!exclude)
-            {
-                if (LootItems.find(itr->second.ItemId) != LootItems.end())
-                {
-                    isLoot = true;
+void AHBConfig::MarkMarketChanged()
+{
+    ++marketVersion;
+}
 
-                    if (!Loot_TGs)
-                    {
-                        exclude = true;
-                    }
-                }
-            }
+bool AHBConfig::NeedsRestock(uint32 botId)
+{
+    //
+    // An expiring auction leaves room in the market even if its removal went unnoticed
+    //
 
-            if (exclude)
-            {
-                continue;
-            }
+    time_t now     = time(NULL);
+    bool   expired = false;
 
-            if (!Other_TGs)
-            {
-                if (!isNpc && !isLoot)
-                {
-                    continue;
-                }
-            }
-        }
+    while (!botExpiries.empty() && botExpiries.top() <= now)
+    {
+        botExpiries.pop();
+        expired = true;
+    }
 
-        //
-        // Exclude loot items
-        //
+    if (expired)
+    {
+        MarkMarketChanged();
+    }
 
-        if (itr->second.Class != ITEM_CLASS_TRADE_GOODS)
-        {
-            bool isNpc   = false;
-            bool isLoot  = false;
-            bool exclude = false;
+    std::unordered_map<uint32, uint64>::const_iterator itr = botRestockedVersion.find(botId);
 
-            if (NpcItems.find(itr->second.ItemId) != NpcItems.end())
-            {
-                isNpc = true;
+    return itr == botRestockedVersion.end() || itr->second != marketVersion;
+}
 
-                if (!Vendor_Items)
-                {
-                    exclude = true;
-                }
-            }
+void AHBConfig::SetRestocked(uint32 botId)
+{
+    botRestockedVersion[botId] = marketVersion;
+}
 
-            if (!exclude)
-            {
-                if (LootItems.find(itr->second.ItemId) != LootItems.end())
-                {
-                    isLoot = true;
+void AHBConfig::SetBidsPerInterval(uint32 value)
+{
+    buyerBidsPerInterval = value;
+}
 
-                    if (!Loot_Items)
-                    {
-                        exclude = true;
-                    }
-                }
-            }
+uint32 AHBConfig::GetBidsPerInterval()
+{
+    return buyerBidsPerInterval;
+}
 
-            if (exclude)
-            {
-                continue;
-            }
+uint32 AHBConfig::GetAuctionDeposit(AuctionHouseEntry const* ahEntry, uint32 elapsingTime, Item* item, uint32 stackCount)
+{
+    //
+    // The core rounds the duration down to blocks of twelve hours, so it is enough to tell the durations apart
+    //
 
-            if (!Other_Items)
-            {
-                if (!isNpc && !isLoot)
-                {
-                    continue;
-                }
-            }
-        }
+    uint32 timeClass = elapsingTime / (12 * HOUR);
+    uint64 key       = (uint64(item->GetEntry()) << 32) | (uint64(stackCount) << 8) | timeClass;
 
-        //
-        // Verify if the item is disabled or not in the whitelist
-        //
+    std::unordered_map<uint64, uint32>::const_iterator itr = depositCache.find(key);
 
-        if (SellerWhiteList.size() == 0)
-        {
-            if (DisableItemStore.find(itr->second.ItemId) != DisableItemStore.end())
-            {
-                if (DebugOutFilters)
-                {
-                    LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (PTR/Beta/Unused Item)", itr->second.ItemId);
-                }
+    if (itr != depositCache.end())
+    {
+        return itr->second;
+    }
 
-                continue;
-            }
-        }
-        else
-        {
-            if (SellerWhiteList.find(itr->second.ItemId) == SellerWhiteList.end())
-            {
-                if (DebugOutFilters)
-                {
-                    LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (not in the whitelist)", itr->second.ItemId);
-                }
+    uint32 deposit = sAuctionMgr->GetAuctionDeposit(ahEntry, elapsingTime, item, stackCount);
 
-                continue;
-            }
-        }
+    //
+    // Every template can be sold with many stack sizes: start over once the cache is full, the
+    // deposits in use are computed again in a few cycles
+    //
 
-        //
-        // Disable permanent enchants items
-        //
+    if (depositCache.size() >= AHB_DEPOSIT_CACHE)
+    {
+        depositCache.clear();
+    }
 
-        if ((DisablePermEnchant) && (itr->second.Class == ITEM_CLASS_PERMANENT))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Permanent Enchant Item)", itr->second.ItemId);
-            }
+    depositCache[key] = deposit;
 
-            continue;
-        }
+    return deposit;
+}
 
-        //
-        // Disable conjured items
-        //
+void AHBConfig::UpdateItemStats(uint32 id, uint32 stackSize, uint64 buyout)
+{
+    if (!stackSize)
+    {
+        return;
+    }
 
-        if ((DisableConjured) && (itr->second.IsConjuredConsumable()))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Conjured Consumable)", itr->second.ItemId);
-            }
+    // 
+    // Collects information about the item bought
+    //
 
-            continue;
-        }
+    uint32 perUnit = buyout / stackSize;
+
+    if (itemsCount.count(id) == 0)
+    {
+        itemsCount[id] = 1;
+        itemsSum[id]   = perUnit;
+        itemsPrice[id] = perUnit;
+    }
+    else
+    {
+        itemsCount[id]++;
 
         //
-        // Disable gems
+        // Reset the statistics to force adapt to the market price.
+        // Adds a little of randomness by adding/removing a range of 9 to the threshold.
         //
 
-        if ((DisableGems) && (itr->second.Class == ITEM_CLASS_GEM))
+        if (itemsCount[id] > MarketResetThreshold + (urand(1, 19) - 10))
         {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Gem)", itr->second.ItemId);
-            }
+            itemsCount[id] = 1;
+            itemsSum[id]   = perUnit;
+            itemsPrice[id] = perUnit;
+        }
+        else
+        {
+            //
+            // Here is decided the price for single unit:
+            // right now is a plain, boring average of the ~100 previous auctions.
+            //
 
-            continue;
+            itemsSum[id]   = (itemsSum[id] + perUnit);
+            itemsPrice[id] = itemsSum[id] / itemsCount[id];
         }
+    }
 
-        //
-        // Disable money
-        //
+    if (DebugOutConfig)
+    {
+        LOG_INFO("module", "Updating market price item={}, price={}", id, itemsPrice[id]);
+    }
+}
 
-        if ((DisableMoney) && (itr->second.Class == ITEM_CLASS_MONEY))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Money)", itr->second.ItemId);
-            }
+uint64 AHBConfig::GetItemPrice(uint32 id)
+{
+    if (itemsCount.count(id) != 0)
+    {
+        return itemsPrice[id];
+    }
 
-            continue;
-        }
+    return 0;
+}
 
-        //
-        // Disable moneyloot
-        //
+AHBSqlSettings AHBConfig::LoadSqlSettings()
+{
+    //
+    // Columns of mod_auctionhousebot used by the configuration
+    //
 
-        if ((DisableMoneyLoot) && (itr->second.MinMoneyLoot > 0))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (MoneyLoot)", itr->second.ItemId);
-            }
+    static char const* const columns[] =
+    {
+        "minitems", "maxitems",
 
-            continue;
-        }
+        "percentgreytradegoods", "percentwhitetradegoods", "percentgreentradegoods", "percentbluetradegoods",
+        "percentpurpletradegoods", "percentorangetradegoods", "percentyellowtradegoods",
 
-        //
-        // Disable lootable items
-        //
+        "percentgreyitems", "percentwhiteitems", "percentgreenitems", "percentblueitems",
+        "percentpurpleitems", "percentorangeitems", "percentyellowitems",
 
-        if ((DisableLootable) && (itr->second.Flags & 4))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Lootable Item)", itr->second.ItemId);
-            }
+        "minpricegrey", "maxpricegrey", "minpricewhite", "maxpricewhite", "minpricegreen", "maxpricegreen",
+        "minpriceblue", "maxpriceblue", "minpricepurple", "maxpricepurple", "minpriceorange", "maxpriceorange",
+        "minpriceyellow", "maxpriceyellow",
 
-            continue;
-        }
+        "minbidpricegrey", "maxbidpricegrey", "minbidpricewhite", "maxbidpricewhite", "minbidpricegreen", "maxbidpricegreen",
+        "minbidpriceblue", "maxbidpriceblue", "minbidpricepurple", "maxbidpricepurple", "minbidpriceorange", "maxbidpriceorange",
+        "minbidpriceyellow", "maxbidpriceyellow",
 
-        //
-        // Disable Keys
-        //
+        "maxstackgrey", "maxstackwhite", "maxstackgreen", "maxstackblue", "maxstackpurple", "maxstackorange", "maxstackyellow",
 
-        if ((DisableKeys) && (itr->second.Class == ITEM_CLASS_KEY))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Quest Item)", itr->second.ItemId);
-            }
+        "buyerpricegrey", "buyerpricewhite", "buyerpricegreen", "buyerpriceblue", "buyerpricepurple", "buyerpriceorange", "buyerpriceyellow",
 
-            continue;
-        }
+        "buyerbiddinginterval", "buyerbidsperinterval"
+    };
 
-        //
-        // Disable items with duration
-        //
+    //
+    // Fetch the settings of all the auction houses with a single query
+    //
 
-        if ((DisableDuration) && (itr->second.Duration > 0))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Has a Duration)", itr->second.ItemId);
-            }
+    std::string query = "SELECT auctionhouse";
 
-            continue;
-        }
+    for (char const* column : columns)
+    {
+        query += ", ";
+        query += column;
+    }
 
-        //
-        // Disable items which are BOP or Quest Items and have a required level lower than the item level
-        //
+    query += " FROM mod_auctionhousebot";
 
-        if ((DisableBOP_Or_Quest_NoReqLevel) && ((itr->second.Bonding == BIND_WHEN_PICKED_UP || itr->second.Bonding == BIND_QUEST_ITEM) && (itr->second.RequiredLevel < itr->second.ItemLevel)))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (BOP or BQI and Required Level is less than Item Level)", itr->second.ItemId);
-            }
+    AHBSqlSettings settings;
 
-            continue;
-        }
+    QueryResult result = WorldDatabase.Query(query.c_str());
 
-        //
-        // Disable items specifically for Warrior
-        //
+    if (!result)
+    {
+        LOG_ERROR("module", "AHBot: the mod_auctionhousebot table is empty");
+        return settings;
+    }
 
-        if ((DisableWarriorItems) && (itr->second.AllowableClass == AHB_CLASS_WARRIOR))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Warrior Item)", itr->second.ItemId);
-            }
+    do
+    {
+        Field*     fields = result->Fetch();
+        AHBSqlRow& row    = settings[fields[0].Get<uint32>()];
 
-            continue;
+        for (uint32 i = 0; i < std::size(columns); ++i)
+        {
+            row[columns[i]] = fields[i + 1].Get<uint32>();
         }
+    } while (result->NextRow());
 
-        //
-        // Disable items specifically for Paladin
-        //
+    return settings;
+}
 
-        if ((DisablePaladinItems) && (itr->second.AllowableClass == AHB_CLASS_PALADIN))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Paladin Item)", itr->second.ItemId);
-            }
+void AHBConfig::Initialize(AHBSqlSettings const& settings, std::shared_ptr<AHBCatalog const> itemsCatalog)
+{
+    catalog = itemsCatalog;
 
-            continue;
-        }
+    //
+    // The deposit rates may have been reloaded with the configuration
+    //
 
-        //
-        // Disable items specifically for Hunter
-        //
+    depositCache.clear();
 
-        if ((DisableHunterItems) && (itr->second.AllowableClass == AHB_CLASS_HUNTER))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Hunter Item)", itr->second.ItemId);
-            }
+    InitializeFromSql(settings);
+    CompileFilters();
+    InitializeBins();
+}
 
-            continue;
-        }
+void AHBConfig::InitializeMarket(std::set<uint32> botsIds, AHBConfig const* previous)
+{
+    //
+    // Keep the market prices learned so far
+    //
 
-        //
-        // Disable items specifically for Rogue
-        //
+    itemsCount = previous->itemsCount;
+    itemsSum   = previous->itemsSum;
+    itemsPrice = previous->itemsPrice;
+
+    //
+    // Reset the situation of the auction house
+    //
+
+    ResetItemCounts();
+    ResetBotItemCounts();
+
+    botExpiries = {};
+
+    //
+    // Count the auctions of every bot, used for the limits and the duplicates
+    //
+
+    ScanBotAuctions(botsIds, botItemsCount, botAuctionsCount);
+
+    //
+    // Collect the auctions of the players, that the buyer may bid on
+    //
+
+    ScanPlayerAuctions(botsIds);
+
+    //
+    // The reactions still pending are kept. If the previous configuration did not react, at startup
+    // or when the mode has just been enabled, every auction of the players gets its reaction time.
+    //
 
-        if ((DisableRogueItems) && (itr->second.AllowableClass == AHB_CLASS_ROGUE))
+    if (ReactiveBuyer)
+    {
+        if (previous->ReactiveBuyer)
+        {
+            reactiveQueue = previous->reactiveQueue;
+            reactiveReady = previous->reactiveReady;
+            reactiveShare = previous->reactiveShare;
+        }
+        else
         {
-            if (DebugOutFilters)
+            for (uint32 auctionId : playerAuctions)
             {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Rogue Item)", itr->second.ItemId);
+                QueueReactiveAuction(auctionId);
             }
-
-            continue;
         }
+    }
 
-        //
-        // Disable items specifically for Priest
-        //
+    //
+    // Update the situation of the auction house
+    //
+
+    AuctionHouseObject* auctionHouse = sAuctionMgr->GetAuctionsMap(GetAHFID());
+    uint32 numberOfAuctions = auctionHouse->Getcount();
 
-        if ((DisablePriestItems) && (itr->second.AllowableClass == AHB_CLASS_PRIEST))
+    if (numberOfAuctions > 0)
+    {
+        for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctionHouse->GetAuctionsBegin(); itr != auctionHouse->GetAuctionsEnd(); ++itr)
         {
-            if (DebugOutFilters)
+            AuctionEntry* Aentry = itr->second;
+            Item*         item   = sAuctionMgr->GetAItem(Aentry->item_guid);
+
+            //
+            // The auctions of the bots already on the market are added to the restock schedule,
+            // the hooks only see the ones created from now on
+            //
+
+            if (botsIds.find(Aentry->owner.GetCounter()) != botsIds.end())
             {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Priest Item)", itr->second.ItemId);
+                ScheduleExpiry(Aentry->expire_time);
             }
 
-            continue;
-        }
-
-        //
-        // Disable items specifically for DK
-        //
+            //
+            // If it has to only consider the bots auctions, skip the ones belonging to the players
+            //
 
-        if ((DisableDKItems) && (itr->second.AllowableClass == AHB_CLASS_DK))
-        {
-            if (DebugOutFilters)
+            if (ConsiderOnlyBotAuctions)
             {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (DK Item)", itr->second.ItemId);
+                if (botsIds.find(Aentry->owner.GetCounter()) == botsIds.end())
+                {
+                    continue;
+                }
             }
 
-            continue;
-        }
+            if (item)
+            {
+                ItemTemplate const* prototype = item->GetTemplate();
 
-        //
-        // Disable items specifically for Shaman
-        //
+                if (prototype)
+                {
+                    switch (prototype->Quality)
+                    {
+                    case AHB_GREY:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_GREY_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_GREY_I);
+                        }
+                        break;
+
+                    case AHB_WHITE:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_WHITE_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_WHITE_I);
+                        }
+
+                        break;
+
+                    case AHB_GREEN:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_GREEN_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_GREEN_I);
+                        }
+
+                        break;
+
+                    case AHB_BLUE:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_BLUE_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_BLUE_I);
+                        }
+
+                        break;
+
+                    case AHB_PURPLE:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_PURPLE_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_PURPLE_I);
+                        }
+
+                        break;
+
+                    case AHB_ORANGE:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_ORANGE_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_ORANGE_I);
+                        }
+
+                        break;
+
+                    case AHB_YELLOW:
+                        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
+                        {
+                            IncItemCounts(AHB_YELLOW_TG);
+                        }
+                        else
+                        {
+                            IncItemCounts(AHB_YELLOW_I);
+                        }
+
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if (DebugOutConfig)
+    {
+        LOG_INFO("module", "Current situation for the auctionhouse {}", GetAHID());
+        LOG_INFO("module", "    Grey   Trade Goods {}", GetItemCounts(AHB_GREY_TG));
+        LOG_INFO("module", "    White  Trade Goods {}", GetItemCounts(AHB_WHITE_TG));
+        LOG_INFO("module", "    Green  Trade Goods {}", GetItemCounts(AHB_GREEN_TG));
+        LOG_INFO("module", "    Blue   Trade Goods {}", GetItemCounts(AHB_BLUE_TG));
+        LOG_INFO("module", "    Purple Trade Goods {}", GetItemCounts(AHB_PURPLE_TG));
+        LOG_INFO("module", "    Orange Trade Goods {}", GetItemCounts(AHB_ORANGE_TG));
+        LOG_INFO("module", "    Yellow Trade Goods {}", GetItemCounts(AHB_YELLOW_TG));
+        LOG_INFO("module", "    Grey   Items       {}", GetItemCounts(AHB_GREY_I));
+        LOG_INFO("module", "    White  Items       {}", GetItemCounts(AHB_WHITE_I));
+        LOG_INFO("module", "    Green  Items       {}", GetItemCounts(AHB_GREEN_I));
+        LOG_INFO("module", "    Blue   Items       {}", GetItemCounts(AHB_BLUE_I));
+        LOG_INFO("module", "    Purple Items       {}", GetItemCounts(AHB_PURPLE_I));
+        LOG_INFO("module", "    Orange Items       {}", GetItemCounts(AHB_ORANGE_I));
+        LOG_INFO("module", "    Yellow Items       {}", GetItemCounts(AHB_YELLOW_I));
+    }
+}
+
+void AHBConfig::InitializeFromFile()
+{
+    //
+    // Load from, the configuration file
+    //
+
+    DebugOut                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG"        , false);
+    DebugOutConfig                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_CONFIG" , false);
+    DebugOutFilters                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_FILTERS", false);
+    DebugOutBuyer                  = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_BUYER"  , false);
+    DebugOutSeller                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DEBUG_SELLER" , false);
+
+    TraceSeller                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.TRACE_SELLER" , false);
+    TraceBuyer                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.TRACE_BUYER"  , false);
+
+    AHBSeller                      = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.EnableSeller"           , false);
+    AHBBuyer                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.EnableBuyer"            , false);
+    UseBuyPriceForSeller           = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseBuyPriceForSeller"   , false);
+    UseBuyPriceForBuyer            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseBuyPriceForBuyer"    , false);
+    BuyerValueRanked               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.BuyerValueRanked"       , false);
+    ReactiveBuyer                  = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.ReactiveBuyer"          , false);
+    ReactiveBuyerMinDelay          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ReactiveBuyerMinDelay"  , 60);
+    ReactiveBuyerMaxDelay          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ReactiveBuyerMaxDelay"  , 600);
+    SellAtMarketPrice              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.UseMarketPriceForSeller", false);
+    MarketResetThreshold           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.MarketResetThreshold"   , 25);
+    DuplicatesCount                = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DuplicatesCount"        , 0);
+    DivisibleStacks                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DivisibleStacks"        , false);
+    ElapsingTimeClass              = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ElapsingTimeClass"      , 1);
+    ConsiderOnlyBotAuctions        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.ConsiderOnlyBotAuctions", false);
+    ItemsPerCycle                  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.ItemsPerCycle"          , 200);
+    CountersCheckInterval          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.CountersCheckInterval"  , 60);
+    PostingBatchSize               = sConfigMgr->GetOption<uint32>("AuctionHouseBot.PostingBatchSize"       , 0);
+    SellerTimeBudget               = sConfigMgr->GetOption<uint32>("AuctionHouseBot.SellerTimeBudget"       , 0);
+    MaxPostsPerSecond              = sConfigMgr->GetOption<uint32>("AuctionHouseBot.MaxPostsPerSecond"      , 0);
+    MaxBidsPerSecond               = sConfigMgr->GetOption<uint32>("AuctionHouseBot.MaxBidsPerSecond"       , 0);
+    MaxBuyoutsPerSecond            = sConfigMgr->GetOption<uint32>("AuctionHouseBot.MaxBuyoutsPerSecond"    , 0);
+    RateLimitBurst                 = sConfigMgr->GetOption<uint32>("AuctionHouseBot.RateLimitBurst"         , 60);
+    RandomSeed                     = sConfigMgr->GetOption<uint32>("AuctionHouseBot.RandomSeed"             , 0);
+
+    //
+    // The reaction delay is drawn between the two bounds, which must be in order
+    //
+
+    if (ReactiveBuyerMaxDelay < ReactiveBuyerMinDelay)
+    {
+        ReactiveBuyerMaxDelay = ReactiveBuyerMinDelay;
+    }
+
+    ConfigureRateLimits();
+    SeedRandom();
+
+    //
+    // Flags: item types
+    //
+
+    Vendor_Items                   = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.VendorItems"      , false);
+    Loot_Items                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.LootItems"        , true);
+    Other_Items                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.OtherItems"       , false);
+    Vendor_TGs                     = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.VendorTradeGoods" , false);
+    Loot_TGs                       = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.LootTradeGoods"   , true);
+    Other_TGs                      = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.OtherTradeGoods"  , false);
+    Profession_Items               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.ProfessionItems"  , false);
+
+    //
+    // Flags: items binding
+    //
+
+    No_Bind                        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.No_Bind"             , true);
+    Bind_When_Picked_Up            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Picked_Up" , false);
+    Bind_When_Equipped             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Equipped"  , true);
+    Bind_When_Use                  = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_When_Use"       , true);
+    Bind_Quest_Item                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.Bind_Quest_Item"     , false);
+
+    //
+    // Flags: misc
+    //
+
+    DisableConjured                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableConjured"               , false);
+    DisableGems                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableGems"                   , false);
+    DisableMoney                   = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMoney"                  , false);
+    DisableMoneyLoot               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMoneyLoot"              , false);
+    DisableLootable                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableLootable"               , false);
+    DisableKeys                    = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableKeys"                   , false);
+    DisableDuration                = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDuration"               , false);
+    DisableBOP_Or_Quest_NoReqLevel = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableBOP_Or_Quest_NoReqLevel", false);
+
+    //
+    // Flags: items per class
+    //
+
+    DisableWarriorItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableWarriorItems"    , false);
+    DisablePaladinItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisablePaladinItems"    , false);
+    DisableHunterItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableHunterItems"     , false);
+    DisableRogueItems              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableRogueItems"      , false);
+    DisablePriestItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisablePriestItems"     , false);
+    DisableDKItems                 = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDKItems"         , false);
+    DisableShamanItems             = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableShamanItems"     , false);
+    DisableMageItems               = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableMageItems"       , false);
+    DisableWarlockItems            = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableWarlockItems"    , false);
+    DisableUnusedClassItems        = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableUnusedClassItems", false);
+    DisableDruidItems              = sConfigMgr->GetOption<bool>  ("AuctionHouseBot.DisableDruidItems"      , false);
+
+    //
+    // Items level and skills
+    //
+
+    DisableItemsBelowLevel         = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowLevel"       , 0);
+    DisableItemsAboveLevel         = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveLevel"       , 0);
+    DisableItemsBelowGUID          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowGUID"        , 0);
+    DisableItemsAboveGUID          = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveGUID"        , 0);
+    DisableItemsBelowReqLevel      = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowReqLevel"    , 0);
+    DisableItemsAboveReqLevel      = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveReqLevel"    , 0);
+    DisableItemsBelowReqSkillRank  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsBelowReqSkillRank", 0);
+    DisableItemsAboveReqSkillRank  = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableItemsAboveReqSkillRank", 0);
+
+    //
+    // Trade goods level and skills
+    //
+
+    DisableTGsBelowLevel           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowLevel"       , 0);
+    DisableTGsAboveLevel           = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveLevel"       , 0);
+    DisableTGsBelowGUID            = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowGUID"        , 0);
+    DisableTGsAboveGUID            = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveGUID"        , 0);
+    DisableTGsBelowReqLevel        = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowReqLevel"    , 0);
+    DisableTGsAboveReqLevel        = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveReqLevel"    , 0);
+    DisableTGsBelowReqSkillRank    = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsBelowReqSkillRank", 0);
+    DisableTGsAboveReqSkillRank    = sConfigMgr->GetOption<uint32>("AuctionHouseBot.DisableTGsAboveReqSkillRank", 0);
+
+    //
+    // Whitelists
+    //
+
+    std::shared_ptr<AHBItemBitmap> whiteList = std::make_shared<AHBItemBitmap>();
+    std::set<uint32>               whiteIds  = getCommaSeparatedIntegers(sConfigMgr->GetOption<std::string>("AuctionHouseBot.SellerWhiteList", ""));
+
+    for (uint32 id : whiteIds)
+    {
+        //
+        // The bitmap grows up to the highest id, so only the ids of actual items are kept
+        //
+
+        if (!sObjectMgr->GetItemTemplate(id))
+        {
+            LOG_ERROR("module", "AHBot: item {} of the whitelist does not exist", id);
+            continue;
+        }
+
+        whiteList->Insert(id);
+    }
+
+    SellerWhiteList                = whiteList;
+    SellerWhiteListConfigured      = !whiteIds.empty();
+}
+
+void AHBConfig::InitializeFromRow(AHBSqlRow const& row)
+{
+    //
+    // Load min and max items
+    //
+
+    SetMinItems(row.at("minitems"));
+    SetMaxItems(row.at("maxitems"));
+
+    //
+    // Load percentages
+    //
+
+    uint32 greytg   = row.at("percentgreytradegoods");
+    uint32 whitetg  = row.at("percentwhitetradegoods");
+    uint32 greentg  = row.at("percentgreentradegoods");
+    uint32 bluetg   = row.at("percentbluetradegoods");
+    uint32 purpletg = row.at("percentpurpletradegoods");
+    uint32 orangetg = row.at("percentorangetradegoods");
+    uint32 yellowtg = row.at("percentyellowtradegoods");
+
+    uint32 greyi    = row.at("percentgreyitems");
+    uint32 whitei   = row.at("percentwhiteitems");
+    uint32 greeni   = row.at("percentgreenitems");
+    uint32 bluei    = row.at("percentblueitems");
+    uint32 purplei  = row.at("percentpurpleitems");
+    uint32 orangei  = row.at("percentorangeitems");
+    uint32 yellowi  = row.at("percentyellowitems");
+
+    SetPercentages(greytg, whitetg, greentg, bluetg, purpletg, orangetg, yellowtg, greyi, whitei, greeni, bluei, purplei, orangei, yellowi);
+
+    // 
+    // Load min and max prices
+    // 
+
+    SetMinPrice(AHB_GREY  , row.at("minpricegrey"));
+    SetMaxPrice(AHB_GREY  , row.at("maxpricegrey"));
+    SetMinPrice(AHB_WHITE , row.at("minpricewhite"));
+    SetMaxPrice(AHB_WHITE , row.at("maxpricewhite"));
+    SetMinPrice(AHB_GREEN , row.at("minpricegreen"));
+    SetMaxPrice(AHB_GREEN , row.at("maxpricegreen"));
+    SetMinPrice(AHB_BLUE  , row.at("minpriceblue"));
+    SetMaxPrice(AHB_BLUE  , row.at("maxpriceblue"));
+    SetMinPrice(AHB_PURPLE, row.at("minpricepurple"));
+    SetMaxPrice(AHB_PURPLE, row.at("maxpricepurple"));
+    SetMinPrice(AHB_ORANGE, row.at("minpriceorange"));
+    SetMaxPrice(AHB_ORANGE, row.at("maxpriceorange"));
+    SetMinPrice(AHB_YELLOW, row.at("minpriceyellow"));
+    SetMaxPrice(AHB_YELLOW, row.at("maxpriceyellow"));
+
+    // 
+    // Load min and max bid prices
+    // 
+
+    SetMinBidPrice(AHB_GREY  , row.at("minbidpricegrey"));
+    SetMaxBidPrice(AHB_GREY  , row.at("maxbidpricegrey"));
+    SetMinBidPrice(AHB_WHITE , row.at("minbidpricewhite"));
+    SetMaxBidPrice(AHB_WHITE , row.at("maxbidpricewhite"));
+    SetMinBidPrice(AHB_GREEN , row.at("minbidpricegreen"));
+    SetMaxBidPrice(AHB_GREEN , row.at("maxbidpricegreen"));
+    SetMinBidPrice(AHB_BLUE  , row.at("minbidpriceblue"));
+    SetMaxBidPrice(AHB_BLUE  , row.at("maxbidpriceblue"));
+    SetMinBidPrice(AHB_PURPLE, row.at("minbidpricepurple"));
+    SetMaxBidPrice(AHB_PURPLE, row.at("maxbidpricepurple"));
+    SetMinBidPrice(AHB_ORANGE, row.at("minbidpriceorange"));
+    SetMaxBidPrice(AHB_ORANGE, row.at("maxbidpriceorange"));
+    SetMinBidPrice(AHB_YELLOW, row.at("minbidpriceyellow"));
+    SetMaxBidPrice(AHB_YELLOW, row.at("maxbidpriceyellow"));
+
+    // 
+    // Load max stacks
+    // 
+
+    SetMaxStack(AHB_GREY  , row.at("maxstackgrey"));
+    SetMaxStack(AHB_WHITE , row.at("maxstackwhite"));
+    SetMaxStack(AHB_GREEN , row.at("maxstackgreen"));
+    SetMaxStack(AHB_BLUE  , row.at("maxstackblue"));
+    SetMaxStack(AHB_PURPLE, row.at("maxstackpurple"));
+    SetMaxStack(AHB_ORANGE, row.at("maxstackorange"));
+    SetMaxStack(AHB_YELLOW, row.at("maxstackyellow"));
+
+    //
+    // Auctions buyer
+    //
+
+    SetBuyerPrice(AHB_GREY  , row.at("buyerpricegrey"));
+    SetBuyerPrice(AHB_WHITE , row.at("buyerpricewhite"));
+    SetBuyerPrice(AHB_GREEN , row.at("buyerpricegreen"));
+    SetBuyerPrice(AHB_BLUE  , row.at("buyerpriceblue"));
+    SetBuyerPrice(AHB_PURPLE, row.at("buyerpricepurple"));
+    SetBuyerPrice(AHB_ORANGE, row.at("buyerpriceorange"));
+    SetBuyerPrice(AHB_YELLOW, row.at("buyerpriceyellow"));
+
+    //
+    // Load bidding interval
+    //
+
+    SetBiddingInterval(row.at("buyerbiddinginterval"));
+
+    //
+    // Load bids per interval
+    //
+
+    SetBidsPerInterval(row.at("buyerbidsperinterval"));
+}
+
+void AHBConfig::InitializeFromSql(AHBSqlSettings const& settings)
+{
+    //
+    // Settings of this auction house, already loaded for all of them
+    //
+
+    AHBSqlSettings::const_iterator settingsIt = settings.find(GetAHID());
+
+    if (settingsIt == settings.end())
+    {
+        LOG_ERROR("module", "AHBot: no settings for auctionhouse {} in mod_auctionhousebot", GetAHID());
+    }
+    else
+    {
+        InitializeFromRow(settingsIt->second);
+    }
+
+    if (DebugOutConfig)
+    {
+        LOG_INFO("module", "Settings for Auctionhouse {}", GetAHID());
+
+        LOG_INFO("module", "minItems                = {}", GetMinItems());
+        LOG_INFO("module", "maxItems                = {}", GetMaxItems());
+
+        LOG_INFO("module", "percentGreyTradeGoods   = {}", GetPercentages(AHB_GREY_TG));
+        LOG_INFO("module", "percentWhiteTradeGoods  = {}", GetPercentages(AHB_WHITE_TG));
+        LOG_INFO("module", "percentGreenTradeGoods  = {}", GetPercentages(AHB_GREEN_TG));
+        LOG_INFO("module", "percentBlueTradeGoods   = {}", GetPercentages(AHB_BLUE_TG));
+        LOG_INFO("module", "percentPurpleTradeGoods = {}", GetPercentages(AHB_PURPLE_TG));
+        LOG_INFO("module", "percentOrangeTradeGoods = {}", GetPercentages(AHB_ORANGE_TG));
+        LOG_INFO("module", "percentYellowTradeGoods = {}", GetPercentages(AHB_YELLOW_TG));
+        LOG_INFO("module", "percentGreyItems        = {}", GetPercentages(AHB_GREY_I));
+        LOG_INFO("module", "percentWhiteItems       = {}", GetPercentages(AHB_WHITE_I));
+        LOG_INFO("module", "percentGreenItems       = {}", GetPercentages(AHB_GREEN_I));
+        LOG_INFO("module", "percentBlueItems        = {}", GetPercentages(AHB_BLUE_I));
+        LOG_INFO("module", "percentPurpleItems      = {}", GetPercentages(AHB_PURPLE_I));
+        LOG_INFO("module", "percentOrangeItems      = {}", GetPercentages(AHB_ORANGE_I));
+        LOG_INFO("module", "percentYellowItems      = {}", GetPercentages(AHB_YELLOW_I));
+
+        LOG_INFO("module", "minPriceGrey            = {}", GetMinPrice(AHB_GREY));
+        LOG_INFO("module", "maxPriceGrey            = {}", GetMaxPrice(AHB_GREY));
+        LOG_INFO("module", "minPriceWhite           = {}", GetMinPrice(AHB_WHITE));
+        LOG_INFO("module", "maxPriceWhite           = {}", GetMaxPrice(AHB_WHITE));
+        LOG_INFO("module", "minPriceGreen           = {}", GetMinPrice(AHB_GREEN));
+        LOG_INFO("module", "maxPriceGreen           = {}", GetMaxPrice(AHB_GREEN));
+        LOG_INFO("module", "minPriceBlue            = {}", GetMinPrice(AHB_BLUE));
+        LOG_INFO("module", "maxPriceBlue            = {}", GetMaxPrice(AHB_BLUE));
+        LOG_INFO("module", "minPricePurple          = {}", GetMinPrice(AHB_PURPLE));
+        LOG_INFO("module", "maxPricePurple          = {}", GetMaxPrice(AHB_PURPLE));
+        LOG_INFO("module", "minPriceOrange          = {}", GetMinPrice(AHB_ORANGE));
+        LOG_INFO("module", "maxPriceOrange          = {}", GetMaxPrice(AHB_ORANGE));
+        LOG_INFO("module", "minPriceYellow          = {}", GetMinPrice(AHB_YELLOW));
+        LOG_INFO("module", "maxPriceYellow          = {}", GetMaxPrice(AHB_YELLOW));
+
+        LOG_INFO("module", "minBidPriceGrey         = {}", GetMinBidPrice(AHB_GREY));
+        LOG_INFO("module", "maxBidPriceGrey         = {}", GetMaxBidPrice(AHB_GREY));
+        LOG_INFO("module", "minBidPriceWhite        = {}", GetMinBidPrice(AHB_WHITE));
+        LOG_INFO("module", "maxBidPriceWhite        = {}", GetMaxBidPrice(AHB_WHITE));
+        LOG_INFO("module", "minBidPriceGreen        = {}", GetMinBidPrice(AHB_GREEN));
+        LOG_INFO("module", "maxBidPriceGreen        = {}", GetMaxBidPrice(AHB_GREEN));
+        LOG_INFO("module", "minBidPriceBlue         = {}", GetMinBidPrice(AHB_BLUE));
+        LOG_INFO("module", "maxBidPriceBlue         = {}", GetMinBidPrice(AHB_BLUE));
+        LOG_INFO("module", "minBidPricePurple       = {}", GetMinBidPrice(AHB_PURPLE));
+        LOG_INFO("module", "maxBidPricePurple       = {}", GetMaxBidPrice(AHB_PURPLE));
+        LOG_INFO("module", "minBidPriceOrange       = {}", GetMinBidPrice(AHB_ORANGE));
+        LOG_INFO("module", "maxBidPriceOrange       = {}", GetMaxBidPrice(AHB_ORANGE));
+        LOG_INFO("module", "minBidPriceYellow       = {}", GetMinBidPrice(AHB_YELLOW));
+        LOG_INFO("module", "maxBidPriceYellow       = {}", GetMaxBidPrice(AHB_YELLOW));
+
+        LOG_INFO("module", "maxStackGrey            = {}", GetMaxStack(AHB_GREY));
+        LOG_INFO("module", "maxStackWhite           = {}", GetMaxStack(AHB_WHITE));
+        LOG_INFO("module", "maxStackGreen           = {}", GetMaxStack(AHB_GREEN));
+        LOG_INFO("module", "maxStackBlue            = {}", GetMaxStack(AHB_BLUE));
+        LOG_INFO("module", "maxStackPurple          = {}", GetMaxStack(AHB_PURPLE));
+        LOG_INFO("module", "maxStackOrange          = {}", GetMaxStack(AHB_ORANGE));
+        LOG_INFO("module", "maxStackYellow          = {}", GetMaxStack(AHB_YELLOW));
+    }
+
+    //
+    // Now that the buyer prices are known, compute the value of every item for the buyer
+    //
+
+    BuildBuyerValuation();
+
+    if (DebugOutConfig)
+    {
+        LOG_INFO("module", "Current Settings for Auctionhouse {} buyer", GetAHID());
+        LOG_INFO("module", "buyerPriceGrey          = {}", GetBuyerPrice(AHB_GREY));
+        LOG_INFO("module", "buyerPriceWhite         = {}", GetBuyerPrice(AHB_WHITE));
+        LOG_INFO("module", "buyerPriceGreen         = {}", GetBuyerPrice(AHB_GREEN));
+        LOG_INFO("module", "buyerPriceBlue          = {}", GetBuyerPrice(AHB_BLUE));
+        LOG_INFO("module", "buyerPricePurple        = {}", GetBuyerPrice(AHB_PURPLE));
+        LOG_INFO("module", "buyerPriceOrange        = {}", GetBuyerPrice(AHB_ORANGE));
+        LOG_INFO("module", "buyerPriceYellow        = {}", GetBuyerPrice(AHB_YELLOW));
+        LOG_INFO("module", "buyerBiddingInterval    = {}", GetBiddingInterval());
+        LOG_INFO("module", "buyerBidsPerInterval    = {}", GetBidsPerInterval());
+    }
+}
 
-        if ((DisableShamanItems) && (itr->second.AllowableClass == AHB_CLASS_SHAMAN))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Shaman Item)", itr->second.ItemId);
-            }
+//
+// Wrap an exclusion predicate into a filter that compacts a selection of item indexes in place;
+// the loop has no branches and the predicate is inlined, so the compiler can vectorize it
+//
 
-            continue;
-        }
+template<class Predicate>
+static AHBItemFilter MakeItemFilter(char const* name, Predicate excluded)
+{
+    AHBItemFilter filter;
 
-        //
-        // Disable items specifically for Mage
-        //
+    filter.Name        = name;
+    filter.Selectivity = 0.0;
+    filter.Apply       = [excluded](uint32* selection, uint32 count)
+    {
+        uint32 kept = 0;
 
-        if ((DisableMageItems) && (itr->second.AllowableClass == AHB_CLASS_MAGE))
+        for (uint32 n = 0; n < count; ++n)
         {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Mage Item)", itr->second.ItemId);
-            }
+            uint32 i = selection[n];
 
-            continue;
+            selection[kept]  = i;
+            kept            += uint32(!excluded(i));
         }
 
-        //
-        // Disable items specifically for Warlock
-        //
+        return kept;
+    };
 
-        if ((DisableWarlockItems) && (itr->second.AllowableClass == AHB_CLASS_WARLOCK))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Warlock Item)", itr->second.ItemId);
-            }
+    return filter;
+}
 
-            continue;
-        }
+void AHBConfig::CompileFilters()
+{
+    filters.clear();
 
-        //
-        // Disable items specifically for Unused Class
-        //
+    AHBItemColumns const* c = &catalog->Columns;
 
-        if ((DisableUnusedClassItems) && (itr->second.AllowableClass == AHB_CLASS_UNUSED))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Unused Item)", itr->second.ItemId);
-            }
+    auto add = [this](char const* name, auto excluded)
+    {
+        filters.push_back(MakeItemFilter(name, excluded));
+    };
 
-            continue;
-        }
+    //
+    // Only the filters enabled by the configuration are compiled
+    //
 
-        //
-        // Disable items specifically for Druid
-        //
+    if (!No_Bind)             add("No Bind"            , [c](uint32 i) { return c->Bonding[i] == NO_BIND; });
+    if (!Bind_When_Picked_Up) add("Bind When Picked Up", [c](uint32 i) { return c->Bonding[i] == BIND_WHEN_PICKED_UP; });
+    if (!Bind_When_Equipped)  add("Bind When Equipped" , [c](uint32 i) { return c->Bonding[i] == BIND_WHEN_EQUIPPED; });
+    if (!Bind_When_Use)       add("Bind When Use"      , [c](uint32 i) { return c->Bonding[i] == BIND_WHEN_USE; });
+    if (!Bind_Quest_Item)     add("Bind Quest Item"    , [c](uint32 i) { return c->Bonding[i] == BIND_QUEST_ITEM; });
 
-        if ((DisableDruidItems) && (itr->second.AllowableClass == AHB_CLASS_DRUID))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Druid Item)", itr->second.ItemId);
-            }
+    //
+    // Exclude items with no possible price
+    //
 
-            continue;
-        }
+    if (UseBuyPriceForSeller)
+    {
+        add("No Buy Price" , [c](uint32 i) { return c->BuyPrice[i] == 0; });
+    }
+    else
+    {
+        add("No Sell Price", [c](uint32 i) { return c->SellPrice[i] == 0; });
+    }
 
-        //
-        // Disable Items below level X
-        //
+    //
+    // Exclude trade goods and other items according to where they come from
+    //
 
-        if ((DisableItemsBelowLevel) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemLevel < DisableItemsBelowLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Item Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    add("Origin", [this, c](uint32 i)
+    {
+        bool tradeGood = c->Class[i] == ITEM_CLASS_TRADE_GOODS;
+        bool vendor    = tradeGood ? Vendor_TGs : Vendor_Items;
+        bool loot      = tradeGood ? Loot_TGs   : Loot_Items;
+        bool other     = tradeGood ? Other_TGs  : Other_Items;
 
-            continue;
-        }
+        return (c->Npc[i] && !vendor) || (c->Loot[i] && !loot) || (!other && !c->Npc[i] && !c->Loot[i]);
+    });
 
-        //
-        // Disable Items above level X
-        //
+    //
+    // Verify if the item is disabled or not in the whitelist
+    //
 
-        if ((DisableItemsAboveLevel) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemLevel > DisableItemsAboveLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Item Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    if (!SellerWhiteListConfigured)
+    {
+        add("PTR/Beta/Unused Item", [c](uint32 i) { return c->Disabled[i] != 0; });
+    }
+    else
+    {
+        add("not in the whitelist", [this, c](uint32 i) { return !SellerWhiteList->Contains(c->ItemId[i]); });
+    }
 
-            continue;
-        }
+    //
+    // Disable items by kind
+    //
 
-        //
-        // Disable Trade Goods below level X
-        //
+    if (DisablePermEnchant) add("Permanent Enchant Item", [c](uint32 i) { return c->Class[i] == ITEM_CLASS_PERMANENT; });
+    if (DisableConjured)    add("Conjured Consumable"   , [c](uint32 i) { return c->Conjured[i] != 0; });
+    if (DisableGems)        add("Gem"                   , [c](uint32 i) { return c->Class[i] == ITEM_CLASS_GEM; });
+    if (DisableMoney)       add("Money"                 , [c](uint32 i) { return c->Class[i] == ITEM_CLASS_MONEY; });
+    if (DisableMoneyLoot)   add("MoneyLoot"             , [c](uint32 i) { return c->MinMoneyLoot[i] > 0; });
+    if (DisableLootable)    add("Lootable Item"         , [c](uint32 i) { return (c->Flags[i] & 4) != 0; });
+    if (DisableKeys)        add("Quest Item"            , [c](uint32 i) { return c->Class[i] == ITEM_CLASS_KEY; });
+    if (DisableDuration)    add("Has a Duration"        , [c](uint32 i) { return c->Duration[i] > 0; });
 
-        if ((DisableTGsBelowLevel) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemLevel < DisableTGsBelowLevel))
+    if (DisableBOP_Or_Quest_NoReqLevel)
+    {
+        add("BOP or BQI and Required Level is less than Item Level", [c](uint32 i)
         {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Trade Good {} disabled (Trade Good Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+            return (c->Bonding[i] == BIND_WHEN_PICKED_UP || c->Bonding[i] == BIND_QUEST_ITEM) && (c->RequiredLevel[i] < c->ItemLevel[i]);
+        });
+    }
 
-            continue;
-        }
+    //
+    // Disable items specific to a single class
+    //
 
-        //
-        // Disable Trade Goods above level X
-        //
+    if (DisableWarriorItems)     add("Warrior Item"     , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_WARRIOR; });
+    if (DisablePaladinItems)     add("Paladin Item"     , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_PALADIN; });
+    if (DisableHunterItems)      add("Hunter Item"      , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_HUNTER; });
+    if (DisableRogueItems)       add("Rogue Item"       , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_ROGUE; });
+    if (DisablePriestItems)      add("Priest Item"      , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_PRIEST; });
+    if (DisableDKItems)          add("DK Item"          , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_DK; });
+    if (DisableShamanItems)      add("Shaman Item"      , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_SHAMAN; });
+    if (DisableMageItems)        add("Mage Item"        , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_MAGE; });
+    if (DisableWarlockItems)     add("Warlock Item"     , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_WARLOCK; });
+    if (DisableUnusedClassItems) add("Unused Class Item", [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_UNUSED; });
+    if (DisableDruidItems)       add("Druid Item"       , [c](uint32 i) { return c->AllowableClass[i] == AHB_CLASS_DRUID; });
 
-        if ((DisableTGsAboveLevel) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemLevel > DisableTGsAboveLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Trade Good {} disabled (Trade Good Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    //
+    // Disable items and trade goods outside of the level, id, required level and skill ranges
+    //
 
-            continue;
-        }
+    if (DisableItemsBelowLevel)        add("ItemLevelBelow"     , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->ItemLevel[i]         < DisableItemsBelowLevel; });
+    if (DisableItemsAboveLevel)        add("ItemLevelAbove"     , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->ItemLevel[i]         > DisableItemsAboveLevel; });
+    if (DisableTGsBelowLevel)          add("TGLevelBelow"       , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->ItemLevel[i]         < DisableTGsBelowLevel; });
+    if (DisableTGsAboveLevel)          add("TGLevelAbove"       , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->ItemLevel[i]         > DisableTGsAboveLevel; });
+    if (DisableItemsBelowGUID)         add("ItemGUIDBelow"      , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->ItemId[i]            < DisableItemsBelowGUID; });
+    if (DisableItemsAboveGUID)         add("ItemGUIDAbove"      , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->ItemId[i]            > DisableItemsAboveGUID; });
+    if (DisableTGsBelowGUID)           add("TGGUIDBelow"        , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->ItemId[i]            < DisableTGsBelowGUID; });
+    if (DisableTGsAboveGUID)           add("TGGUIDAbove"        , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->ItemId[i]            > DisableTGsAboveGUID; });
+    if (DisableItemsBelowReqLevel)     add("ReqLevelBelow"      , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->RequiredLevel[i]     < DisableItemsBelowReqLevel; });
+    if (DisableItemsAboveReqLevel)     add("ReqLevelAbove"      , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->RequiredLevel[i]     > DisableItemsAboveReqLevel; });
+    if (DisableTGsBelowReqLevel)       add("TGReqLevelBelow"    , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->RequiredLevel[i]     < DisableTGsBelowReqLevel; });
+    if (DisableTGsAboveReqLevel)       add("TGReqLevelAbove"    , [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->RequiredLevel[i]     > DisableTGsAboveReqLevel; });
+    if (DisableItemsBelowReqSkillRank) add("ReqSkillRankBelow"  , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->RequiredSkillRank[i] < DisableItemsBelowReqSkillRank; });
+    if (DisableItemsAboveReqSkillRank) add("ReqSkillRankAbove"  , [this, c](uint32 i) { return c->Class[i] != ITEM_CLASS_TRADE_GOODS && c->RequiredSkillRank[i] > DisableItemsAboveReqSkillRank; });
+    if (DisableTGsBelowReqSkillRank)   add("TGReqSkillRankBelow", [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->RequiredSkillRank[i] < DisableTGsBelowReqSkillRank; });
+    if (DisableTGsAboveReqSkillRank)   add("TGReqSkillRankAbove", [this, c](uint32 i) { return c->Class[i] == ITEM_CLASS_TRADE_GOODS && c->RequiredSkillRank[i] > DisableTGsAboveReqSkillRank; });
 
-        //
-        // Disable Items below GUID X
-        //
+    //
+    // Order the filters by their share of rejected items on a sample of the catalog, so that the most
+    // selective ones run first and shrink the selection seen by the others
+    //
 
-        if ((DisableItemsBelowGUID) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemId < DisableItemsBelowGUID))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Item Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    uint32 nbItems = c->ItemId.size();
+    uint32 step    = std::max<uint32>(1, nbItems / AHB_FILTER_SAMPLES);
 
-            continue;
-        }
+    std::vector<uint32> sample;
 
-        //
-        // Disable Items above GUID X
-        //
+    for (uint32 i = 0; i < nbItems; i += step)
+    {
+        sample.push_back(i);
+    }
 
-        if ((DisableItemsAboveGUID) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemId > DisableItemsAboveGUID))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Item Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    for (AHBItemFilter& filter : filters)
+    {
+        std::vector<uint32> selection = sample;
 
-            continue;
-        }
+        uint32 kept = filter.Apply(selection.data(), selection.size());
 
-        //
-        // Disable Trade Goods below GUID X
-        //
+        filter.Selectivity = sample.empty() ? 0.0 : 1.0 - double(kept) / sample.size();
+    }
 
-        if ((DisableTGsBelowGUID) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemId < DisableTGsBelowGUID))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Trade Good Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    std::stable_sort(filters.begin(), filters.end(), [](AHBItemFilter const& a, AHBItemFilter const& b)
+    {
+        return a.Selectivity > b.Selectivity;
+    });
 
-            continue;
+    if (DebugOutFilters)
+    {
+        for (AHBItemFilter const& filter : filters)
+        {
+            LOG_INFO("module", "AHBot: filter {} for ah {}, sampled rejection {:.1f}%", filter.Name, AHID, filter.Selectivity * 100.0);
         }
+    }
+}
 
-        //
-        // Disable Trade Goods above GUID X
-        //
+void AHBConfig::InitializeBins()
+{
+    //
+    // The bins are plain vectors, so they must be emptied before a reload
+    //
 
-        if ((DisableTGsAboveGUID) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.ItemId > DisableTGsAboveGUID))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (Trade Good Level = {})", itr->second.ItemId, itr->second.ItemLevel);
-            }
+    GreyTradeGoodsBin.clear();
+    WhiteTradeGoodsBin.clear();
+    GreenTradeGoodsBin.clear();
+    BlueTradeGoodsBin.clear();
+    PurpleTradeGoodsBin.clear();
+    OrangeTradeGoodsBin.clear();
+    YellowTradeGoodsBin.clear();
 
-            continue;
-        }
+    GreyItemsBin.clear();
+    WhiteItemsBin.clear();
+    GreenItemsBin.clear();
+    BlueItemsBin.clear();
+    PurpleItemsBin.clear();
+    OrangeItemsBin.clear();
+    YellowItemsBin.clear();
 
-        //
-        // Disable Items for level lower than X
-        //
+    //
+    // Exclude items depending on the configuration; whatever passes all the tests is put in the lists.
+    // Each thread takes a contiguous range of the catalog as its selection and runs the compiled filters
+    // in order, every filter shrinking the selection seen by the next one.
+    //
 
-        if ((DisableItemsBelowReqLevel) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredLevel < DisableItemsBelowReqLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredLevel = {})", itr->second.ItemId, itr->second.RequiredLevel);
-            }
+    std::vector<ItemTemplate const*> const& templates = catalog->Templates;
 
-            continue;
-        }
+    //
+    // The configurations are built one after the other, so this is the whole set of threads of a (re)load.
+    // It leaves a core to the world thread and is bounded whatever the host, a thread is not worth
+    // starting for less than a full range of templates.
+    //
 
-        //
-        // Disable Items for level higher than X
-        //
+    uint32 nbThreads = std::thread::hardware_concurrency();
+    nbThreads        = nbThreads > 1 ? nbThreads - 1 : 1;
+    nbThreads        = std::min<uint32>(nbThreads, AHB_FILTER_THREADS);
+    nbThreads        = std::min<uint32>(nbThreads, (templates.size() + AHB_MIN_FILTER_RANGE - 1) / AHB_MIN_FILTER_RANGE);
+    nbThreads        = std::max(1u, nbThreads);
 
-        if ((DisableItemsAboveReqLevel) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredLevel > DisableItemsAboveReqLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredLevel = {})", itr->second.ItemId, itr->second.RequiredLevel);
-            }
+    uint32 rangeSize = (templates.size() + nbThreads - 1) / nbThreads;
 
-            continue;
-        }
+    std::vector<std::vector<uint32>>                 selections(nbThreads);
+    std::vector<std::vector<uint32>>                 rejected(nbThreads, std::vector<uint32>(filters.size(), 0));
+    std::vector<std::chrono::steady_clock::duration> busy(nbThreads);
 
-        //
-        // Disable Trade Goods for level lower than X
-        //
+    std::chrono::steady_clock::time_point filterStart = std::chrono::steady_clock::now();
 
-        if ((DisableTGsBelowReqLevel) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredLevel < DisableTGsBelowReqLevel))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Trade Good {} disabled (RequiredLevel = {})", itr->second.ItemId, itr->second.RequiredLevel);
-            }
+    auto filterRange = [&](uint32 range)
+    {
+        std::chrono::steady_clock::time_point rangeStart = std::chrono::steady_clock::now();
 
-            continue;
-        }
+        uint32 first = std::min<uint32>(range * rangeSize, templates.size());
+        uint32 last  = std::min<uint32>(first + rangeSize, templates.size());
 
-        //
-        // Disable Trade Goods for level higher than X
-        //
+        std::vector<uint32>& selection = selections[range];
 
-        if ((DisableTGsAboveReqLevel) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredLevel > DisableTGsAboveReqLevel))
+        selection.resize(last - first);
+        std::iota(selection.begin(), selection.end(), first);
+
+        uint32 count = selection.size();
+
+        for (uint32 f = 0; f < filters.size() && count > 0; ++f)
         {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Trade Good {} disabled (RequiredLevel = {})", itr->second.ItemId, itr->second.RequiredLevel);
-            }
+            uint32 kept = filters[f].Apply(selection.data(), count);
 
-            continue;
+            rejected[range][f] += count - kept;
+            count               = kept;
         }
 
-        //
-        // Disable Items that require skill lower than X
-        //
+        selection.resize(count);
 
-        if ((DisableItemsBelowReqSkillRank) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredSkillRank < DisableItemsBelowReqSkillRank))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredSkillRank = {})", itr->second.ItemId, itr->second.RequiredSkillRank);
-            }
+        busy[range] = std::chrono::steady_clock::now() - rangeStart;
+    };
 
-            continue;
-        }
+    std::vector<std::thread> workers;
 
-        //
-        // Disable Items that require skill higher than X
-        //
+    for (uint32 range = 1; range < nbThreads; ++range)
+    {
+        workers.emplace_back(filterRange, range);
+    }
 
-        if ((DisableItemsAboveReqSkillRank) && (itr->second.Class != ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredSkillRank > DisableItemsAboveReqSkillRank))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredSkillRank = {})", itr->second.ItemId, itr->second.RequiredSkillRank);
-            }
+    filterRange(0);
 
-            continue;
-        }
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
 
-        //
-        // Disable Trade Goods that require skill lower than X
-        //
+    std::chrono::steady_clock::duration filterTime = std::chrono::steady_clock::now() - filterStart;
+    std::chrono::steady_clock::duration busyTime   = std::chrono::steady_clock::duration::zero();
 
-        if ((DisableTGsBelowReqSkillRank) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredSkillRank < DisableTGsBelowReqSkillRank))
-        {
-            if (DebugOutFilters)
-            {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredSkillRank = {})", itr->second.ItemId, itr->second.RequiredSkillRank);
-            }
+    for (std::chrono::steady_clock::duration rangeTime : busy)
+    {
+        busyTime += rangeTime;
+    }
 
-            continue;
-        }
+    //
+    // The time spent filtering by all the threads over the wall time: how many threads were busy on
+    // average, not a speedup, since a single thread would not have run the ranges in the same time
+    //
 
-        //
-        // Disable Trade Goods that require skill higher than X
-        //
+    LOG_INFO("module", "AHBot: filtered {} items for ah {} in {}ms with {} threads, parallelism {:.1f}",
+        uint32(templates.size()), AHID,
+        uint32(std::chrono::duration_cast<std::chrono::milliseconds>(filterTime).count()), nbThreads,
+        filterTime.count() > 0 ? double(busyTime.count()) / double(filterTime.count()) : 1.0);
 
-        if ((DisableTGsAboveReqSkillRank) && (itr->second.Class == ITEM_CLASS_TRADE_GOODS) && (itr->second.RequiredSkillRank > DisableTGsAboveReqSkillRank))
+    //
+    // Report how many items every filter took out, in place of a line for every excluded item
+    //
+
+    if (DebugOutFilters)
+    {
+        for (uint32 f = 0; f < filters.size(); ++f)
         {
-            if (DebugOutFilters)
+            uint32 total = 0;
+
+            for (uint32 range = 0; range < nbThreads; ++range)
             {
-                LOG_ERROR("module", "AuctionHouseBot: Item {} disabled (RequiredSkillRank = {})", itr->second.ItemId, itr->second.RequiredSkillRank);
+                total += rejected[range][f];
             }
 
-            continue;
+            LOG_INFO("module", "AHBot: filter {} rejected {} items for ah {}", filters[f].Name, total, AHID);
         }
+    }
+
+    //
+    // A single sweep over the selections fills the bins: the ranges are contiguous and the filters keep
+    // the order, so the bins are already sorted by id like the catalog
+    //
+
+    for (std::vector<uint32> const& selection : selections)
+    for (uint32 i : selection)
+    {
+        ItemTemplate const* prototype = templates[i];
 
         //
         // Now that the items passed all the tests, organize it by quality
         //
 
-        if (itr->second.Class == ITEM_CLASS_TRADE_GOODS)
+        AHBItemProfile profile;
+
+        profile.ItemId         = prototype->ItemId;
+        profile.Quality        = prototype->Quality;
+        profile.BasePrice      = UseBuyPriceForSeller ? prototype->BuyPrice : prototype->SellPrice;
+        profile.MaxStackCount  = prototype->GetMaxStackSize();
+        profile.RandomProperty = prototype->RandomProperty != 0 || prototype->RandomSuffix != 0;
+
+        if (prototype->Class == ITEM_CLASS_TRADE_GOODS)
         {
-            switch (itr->second.Quality)
+            switch (prototype->Quality)
             {
             case AHB_GREY:
-                GreyTradeGoodsBin.insert(itr->second.ItemId);
+                GreyTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_WHITE:
-                WhiteTradeGoodsBin.insert(itr->second.ItemId);
+                WhiteTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_GREEN:
-                GreenTradeGoodsBin.insert(itr->second.ItemId);
+                GreenTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_BLUE:
-                BlueTradeGoodsBin.insert(itr->second.ItemId);
+                BlueTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_PURPLE:
-                PurpleTradeGoodsBin.insert(itr->second.ItemId);
+                PurpleTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_ORANGE:
-                OrangeTradeGoodsBin.insert(itr->second.ItemId);
+                OrangeTradeGoodsBin.push_back(profile);
                 break;
 
             case AHB_YELLOW:
-                YellowTradeGoodsBin.insert(itr->second.ItemId);
+                YellowTradeGoodsBin.push_back(profile);
                 break;
             }
         }
         else
         {
-            switch (itr->second.Quality)
+            switch (prototype->Quality)
             {
             case AHB_GREY:
-                GreyItemsBin.insert(itr->second.ItemId);
+                GreyItemsBin.push_back(profile);
                 break;
 
             case AHB_WHITE:
-                WhiteItemsBin.insert(itr->second.ItemId);
+                WhiteItemsBin.push_back(profile);
                 break;
 
             case AHB_GREEN:
-                GreenItemsBin.insert(itr->second.ItemId);
+                GreenItemsBin.push_back(profile);
                 break;
 
             case AHB_BLUE:
-                BlueItemsBin.insert(itr->second.ItemId);
+                BlueItemsBin.push_back(profile);
                 break;
 
             case AHB_PURPLE:
-                PurpleItemsBin.insert(itr->second.ItemId);
+                PurpleItemsBin.push_back(profile);
                 break;
 
             case AHB_ORANGE:
-                OrangeItemsBin.insert(itr->second.ItemId);
+                OrangeItemsBin.push_back(profile);
                 break;
 
             case AHB_YELLOW:
-                YellowItemsBin.insert(itr->second.ItemId);
+                YellowItemsBin.push_back(profile);
                 break;
             }
         }
     }
 
-    // 
+    //
     // Perform reporting and the last check: if no items are disabled or in the whitelist clear the bin making the selling useless
     // 
 
     LOG_INFO("module", "AHBot: Configuration for ah {}", AHID);
 
-    if (SellerWhiteList.size() == 0)
+    if (!SellerWhiteListConfigured)
     {
-        if (DisableItemStore.size() == 0)
+        if (catalog->DisableItemStore.Empty())
         {
             LOG_ERROR("module", "AHBot: No items are disabled or in the whitelist! Selling will be disabled!");
 
@@ -3416,11 +3702,15 @@ void AHBConfig::InitializeBins()
             return;
         }
 
-        LOG_INFO("module", "AHBot: {} disabled items", uint32(DisableItemStore.size()));
+        LOG_INFO("module", "AHBot: {} disabled items", catalog->DisableItemStore.Count());
+    }
+    else if (SellerWhiteList->Empty())
+    {
+        LOG_ERROR("module", "AHBot: None of the whitelisted items exist! Nothing will be sold!");
     }
     else
     {
-        LOG_INFO("module", "AHBot: Using a whitelist of {} items", uint32(SellerWhiteList.size()));
+        LOG_INFO("module", "AHBot: Using a whitelist of {} items", SellerWhiteList->Count());
     }
 
     LOG_INFO("module", "AHBot: loaded {} grey   trade goods", uint32(GreyTradeGoodsBin.size()));
@@ -3458,3 +3748,45 @@ std::set<uint32> AHBConfig::getCommaSeparatedIntegers(std::string text)
 
     return ret;
 }
+
+void AHBConfig::SeedRandom()
+{
+    //
+    // Seeded like the bots; the id of the auction house is complemented so the stream differs from the ones of the bots
+    //
+
+    if (RandomSeed == 0)
+    {
+        random.Seed((uint64(std::random_device()()) << 32) | std::random_device()());
+    }
+    else
+    {
+        random.Seed(~((uint64(RandomSeed) << 32) | AHID));
+    }
+}
+
+void AHBConfig::ConfigureRateLimits()
+{
+    //
+    // The auction house is updated about once a minute, the burst lets the bots use the quota saved in between
+    //
+
+    postsBucket  .Configure(MaxPostsPerSecond  , RateLimitBurst);
+    bidsBucket   .Configure(MaxBidsPerSecond   , RateLimitBurst);
+    buyoutsBucket.Configure(MaxBuyoutsPerSecond, RateLimitBurst);
+}
+
+bool AHBConfig::TryConsumePost()
+{
+    return postsBucket.TryConsume();
+}
+
+bool AHBConfig::TryConsumeBid()
+{
+    return bidsBucket.TryConsume();
+}
+
+bool AHBConfig::TryConsumeBuyout()
+{
+    return buyoutsBucket.TryConsume();
+}
@@ -20,12 +20,68 @@
 #ifndef AUCTION_HOUSE_BOT_CONFIG_H
 #define AUCTION_HOUSE_BOT_CONFIG_H
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <queue>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "ObjectMgr.h"
 
+#include "AuctionHouseBotCatalog.h"
+#include "AuctionHouseBotRandom.h"
+#include "AuctionHouseBotTokenBucket.h"
+
+//
+// Static facts about an item template, computed once when the bins are filled
+//
+
+struct AHBItemProfile
+{
+    uint32 ItemId;
+    uint32 Quality;
+    uint32 BasePrice;      // Buy or sell price, according to UseBuyPriceForSeller
+    uint32 MaxStackCount;  // Maximum stack size allowed by the template
+    bool   RandomProperty; // Random properties or suffixes may be applied
+
+    bool operator<(AHBItemProfile const& other) const { return ItemId < other.ItemId; }
+};
+
+//
+// Rows of the mod_auctionhousebot table, by auction house and then by column name
+//
+
+typedef std::unordered_map<std::string, uint32>   AHBSqlRow;
+typedef std::unordered_map<uint32, AHBSqlRow>     AHBSqlSettings;
+
+//
+// Per quality parameters of the seller, copied once per cycle
+//
+
+struct AHBSellerParams
+{
+    uint32 MinPrice;
+    uint32 MaxPrice;
+    uint32 MinBidPrice;
+    uint32 MaxBidPrice;
+    uint32 MaxStack;
+};
+
+//
+// Filter of the item templates compiled from the configuration: it compacts a selection of indexes
+// in the catalog, keeping only the items it accepts, and returns how many are left
+//
+
+struct AHBItemFilter
+{
+    std::string                            Name;
+    std::function<uint32(uint32*, uint32)> Apply;
+    double                                 Selectivity; // Share of the sampled items rejected
+};
+
 class AHBConfig
 {
 private:
@@ -151,8 +207,98 @@ private:
     std::map<uint32, uint64> itemsSum;
     std::map<uint32, uint64> itemsPrice;
 
-    void   InitializeFromFile();
-    void   InitializeFromSql(std::set<uint32> botsIds);
+    //
+    // Live auctions of the bots, per owner and item template
+    //
+
+    std::unordered_map<uint64, uint32> botItemsCount;
+    std::unordered_map<uint32, uint32> botAuctionsCount;
+    time_t                             botCountersCheck;
+    bool                               botCountersForced; // Check at the next cycle, even if the checks are disabled
+
+    //
+    // Restock scheduling: a bot sells again only when the market changed after its last complete run
+    //
+
+    std::priority_queue<time_t, std::vector<time_t>, std::greater<time_t>> botExpiries;
+    uint64                                                                 marketVersion;
+    std::unordered_map<uint32, uint64>                                     botRestockedVersion;
+
+    //
+    // Live auctions owned by the players, the candidates of the buyer
+    //
+
+    std::vector<uint32>                playerAuctions;
+    std::unordered_map<uint32, uint32> playerAuctionsIndex;
+
+    void   ScanPlayerAuctions(std::set<uint32> const& botsIds);
+
+    //
+    // New player auctions waiting for the reaction time of the buyer
+    //
+
+    std::priority_queue<std::pair<time_t, uint32>, std::vector<std::pair<time_t, uint32>>, std::greater<std::pair<time_t, uint32>>> reactiveQueue;
+
+    //
+    // Auctions whose reaction time is over, shared out between the bots in slices of the same size
+    //
+
+    std::vector<uint32> reactiveReady;
+    uint32              reactiveShare;
+
+    //
+    // Maximum unit bid of the buyer for every item template, zero when it is never bought
+    //
+
+    std::vector<uint64> buyerValuation;
+
+    //
+    // Player auctions ranked by the ratio between the maximum bid of the buyer and the current price
+    //
+
+    std::set<std::pair<double, uint32>, std::greater<std::pair<double, uint32>>> valueRanking;
+    std::unordered_map<uint32, double>                                          valueRankingKey;
+
+    double GetAuctionValue   (AuctionEntry const* auction, uint32 currentPrice);
+    void   SetAuctionValue   (uint32 auctionId, double value);
+
+    //
+    // Deposits already computed, by item template, stack size and duration class, up to AHB_DEPOSIT_CACHE
+    //
+
+    std::unordered_map<uint64, uint32> depositCache;
+
+    //
+    // Rate of the database writes issued by the bots on this market
+    //
+
+    AHBTokenBucket postsBucket;
+    AHBTokenBucket bidsBucket;
+    AHBTokenBucket buyoutsBucket;
+
+    void   ConfigureRateLimits();
+
+    //
+    // Random numbers of the configuration, used for the reaction delays of the buyer
+    //
+
+    AHBRandom random;
+
+    void   SeedRandom();
+
+    void   ScanBotAuctions(std::set<uint32> const& botsIds, std::unordered_map<uint64, uint32>& itemsCount, std::unordered_map<uint32, uint32>& auctionsCount);
+
+    void   InitializeFromSql(AHBSqlSettings const& settings);
+    void   InitializeFromRow(AHBSqlRow const& row);
+
+    //
+    // Filters enabled by the configuration, most selective first. They point to this configuration
+    // and its catalog, so they are compiled again rather than copied.
+    //
+
+    std::vector<AHBItemFilter> filters;
+
+    void   CompileFilters();
 
     std::set<uint32> getCommaSeparatedIntegers(std::string text);
 
@@ -184,11 +330,23 @@ public:
     bool   AHBSeller;
     bool   AHBBuyer;
     bool   UseBuyPriceForBuyer;
+    bool   BuyerValueRanked;
+    bool   ReactiveBuyer;
+    uint32 ReactiveBuyerMinDelay;
+    uint32 ReactiveBuyerMaxDelay;
     bool   UseBuyPriceForSeller;
     bool   SellAtMarketPrice;
     uint32 MarketResetThreshold;
     bool   ConsiderOnlyBotAuctions;
     uint32 ItemsPerCycle;
+    uint32 CountersCheckInterval;
+    uint32 PostingBatchSize;
+    uint32 SellerTimeBudget;
+    uint32 MaxPostsPerSecond;
+    uint32 MaxBidsPerSecond;
+    uint32 MaxBuyoutsPerSecond;
+    uint32 RateLimitBurst;
+    uint32 RandomSeed;
 
     //
     // Filters
@@ -262,34 +420,34 @@ public:
     // Items validity for selling purposes
     //
 
-    std::set<uint32> NpcItems;
-    std::set<uint32> LootItems;
-    std::set<uint32> DisableItemStore;
-    std::set<uint32> SellerWhiteList;
+    std::shared_ptr<AHBCatalog const>    catalog;         // Shared by all the auction houses
+    std::shared_ptr<AHBItemBitmap const> SellerWhiteList; // Shared with the copies, never null once initialized
+
+    bool   SellerWhiteListConfigured;                     // Set even if none of the listed items exist: nothing is sold then
 
     //
     // Bins for trade goods.
     //
 
-    std::set<uint32> GreyTradeGoodsBin;
-    std::set<uint32> WhiteTradeGoodsBin;
-    std::set<uint32> GreenTradeGoodsBin;
-    std::set<uint32> BlueTradeGoodsBin;
-    std::set<uint32> PurpleTradeGoodsBin;
-    std::set<uint32> OrangeTradeGoodsBin;
-    std::set<uint32> YellowTradeGoodsBin;
+    std::vector<AHBItemProfile> GreyTradeGoodsBin;
+    std::vector<AHBItemProfile> WhiteTradeGoodsBin;
+    std::vector<AHBItemProfile> GreenTradeGoodsBin;
+    std::vector<AHBItemProfile> BlueTradeGoodsBin;
+    std::vector<AHBItemProfile> PurpleTradeGoodsBin;
+    std::vector<AHBItemProfile> OrangeTradeGoodsBin;
+    std::vector<AHBItemProfile> YellowTradeGoodsBin;
 
     //
     // Bins for items
     //
 
-    std::set<uint32> GreyItemsBin;
-    std::set<uint32> WhiteItemsBin;
-    std::set<uint32> GreenItemsBin;
-    std::set<uint32> BlueItemsBin;
-    std::set<uint32> PurpleItemsBin;
-    std::set<uint32> OrangeItemsBin;
-    std::set<uint32> YellowItemsBin;
+    std::vector<AHBItemProfile> GreyItemsBin;
+    std::vector<AHBItemProfile> WhiteItemsBin;
+    std::vector<AHBItemProfile> GreenItemsBin;
+    std::vector<AHBItemProfile> BlueItemsBin;
+    std::vector<AHBItemProfile> PurpleItemsBin;
+    std::vector<AHBItemProfile> OrangeItemsBin;
+    std::vector<AHBItemProfile> YellowItemsBin;
 
     //
     // Constructors/destructors
@@ -304,7 +462,18 @@ public:
     // Ruotines
     //
 
-    void   Initialize(std::set<uint32> botsIds);
+    //
+    // The configuration file is read from the world thread, as a reload may replace it at any time.
+    // The settings and the bins do not depend on the game state and can be built by any thread,
+    // while the auctions of the market must be scanned from the world thread. The state gathered
+    // while running (market prices, pending reactions) is taken over from the previous configuration.
+    //
+
+    void   InitializeFromFile();
+    void   Initialize(AHBSqlSettings const& settings, std::shared_ptr<AHBCatalog const> itemsCatalog);
+    void   InitializeMarket(std::set<uint32> botsIds, AHBConfig const* previous);
+
+    static AHBSqlSettings LoadSqlSettings();
     void   InitializeBins();
     void   Reset();
 
@@ -359,6 +528,44 @@ public:
 
     uint32 GetItemCounts     (uint32 color);
 
+    std::vector<AHBItemProfile> const& GetBin(uint32 ahbotItemType);
+    void   GetSellerParams   (AHBSellerParams* params);
+
+    void   IncBotItemCount   (uint32 botId, uint32 itemId);
+    void   DecBotItemCount   (uint32 botId, uint32 itemId);
+    uint32 GetBotItemCount   (uint32 botId, uint32 itemId);
+    uint32 GetBotAuctionCount(uint32 botId);
+    void   ResetBotItemCounts();
+    void   CheckBotCounters  ();
+    void   ForceBotCountersCheck();
+
+    void   AddPlayerAuction   (AuctionEntry const* auction);
+    void   RemovePlayerAuction(uint32 auctionId);
+    uint32 GetPlayerAuctionsCount();
+    void   SamplePlayerAuctions(uint32 botId, AHBRandom& random, uint32 count, std::vector<uint32>& sample);
+
+    void   QueueReactiveAuction  (uint32 auctionId);
+    void   PopDueReactiveAuctions(std::vector<uint32>& due);
+    bool   HasDueReactiveAuctions();
+
+    void   BuildBuyerValuation();
+    uint64 GetBuyerValuation  (uint32 itemId);
+
+    void   UpdateAuctionValue   (AuctionEntry const* auction, uint32 currentPrice);
+    void   RebuildValueRanking  ();
+    void   SelectValuableAuctions(uint32 botId, uint32 count, std::vector<uint32>& sample);
+
+    void   ScheduleExpiry    (time_t expireTime);
+    void   MarkMarketChanged ();
+    bool   NeedsRestock      (uint32 botId);
+    void   SetRestocked      (uint32 botId);
+
+    bool   TryConsumePost    ();
+    bool   TryConsumeBid     ();
+    bool   TryConsumeBuyout  ();
+
+    uint32 GetAuctionDeposit (AuctionHouseEntry const* ahEntry, uint32 elapsingTime, Item* item, uint32 stackCount);
+
     void   UpdateItemStats   (uint32 id, uint32 stackSize, uint64 buyout);
     uint64 GetItemPrice      (uint32 id);
 };
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#include "AuctionHouseBotRandom.h"
+
+static inline uint64 RotateLeft(uint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+AHBRandom::AHBRandom()
+{
+    Seed(0);
+}
+
+uint64 AHBRandom::SplitMix(uint64& seed)
+{
+    uint64 z = (seed += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+void AHBRandom::Seed(uint64 seed)
+{
+    //
+    // The state must never be all zeros, which splitmix guarantees
+    //
+
+    for (uint32 i = 0; i < 4; ++i)
+    {
+        _state[i] = SplitMix(seed);
+    }
+}
+
+uint64 AHBRandom::Next()
+{
+    uint64 result = RotateLeft(_state[1] * 5, 7) * 9;
+    uint64 t      = _state[1] << 17;
+
+    _state[2] ^= _state[0];
+    _state[3] ^= _state[1];
+    _state[1] ^= _state[2];
+    _state[0] ^= _state[3];
+
+    _state[2] ^= t;
+    _state[3]  = RotateLeft(_state[3], 45);
+
+    return result;
+}
+
+uint32 AHBRandom::Range(uint32 min, uint32 max)
+{
+    if (max <= min)
+    {
+        return min;
+    }
+
+    //
+    // Multiply and shift: the bias is negligible for the ranges used by the bot
+    //
+
+    uint64 span = uint64(max - min) + 1;
+
+    return min + uint32(((Next() >> 32) * span) >> 32);
+}
+
+double AHBRandom::Real()
+{
+    return (Next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void AHBRandom::Fill(uint32* values, uint32 count, uint32 min, uint32 max)
+{
+    for (uint32 i = 0; i < count; ++i)
+    {
+        values[i] = Range(min, max);
+    }
+}
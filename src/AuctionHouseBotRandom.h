@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#ifndef AUCTION_HOUSE_BOT_RANDOM_H
+#define AUCTION_HOUSE_BOT_RANDOM_H
+
+#include "Common.h"
+
+// =============================================================================
+// Random numbers stream owned by a single bot (xoshiro256**)
+// =============================================================================
+
+class AHBRandom
+{
+private:
+    uint64 _state[4];
+
+    static uint64 SplitMix(uint64& seed);
+
+public:
+    AHBRandom();
+
+    //
+    // Restart the stream; the same seed always gives the same sequence
+    //
+
+    void   Seed (uint64 seed);
+
+    uint64 Next ();
+    uint32 Range(uint32 min, uint32 max);
+    double Real ();
+
+    //
+    // Bulk draws of values within [min, max]
+    //
+
+    void   Fill (uint32* values, uint32 count, uint32 min, uint32 max);
+};
+
+#endif /* AUCTION_HOUSE_BOT_RANDOM_H */
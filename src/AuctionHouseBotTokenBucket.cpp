@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#include <algorithm>
+
+#include "AuctionHouseBotTokenBucket.h"
+
+AHBTokenBucket::AHBTokenBucket()
+{
+    Configure(0, 0);
+}
+
+void AHBTokenBucket::Configure(uint32 ratePerSecond, uint32 burstSeconds)
+{
+    _rate       = ratePerSecond;
+    _capacity   = std::max(1.0, double(ratePerSecond) * burstSeconds);
+    _tokens     = _capacity;
+    _lastRefill = std::chrono::steady_clock::now();
+}
+
+bool AHBTokenBucket::TryConsume()
+{
+    if (_rate == 0.0)
+    {
+        return true;
+    }
+
+    //
+    // Add the tokens earned since the last call
+    //
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed     = now - _lastRefill;
+
+    _tokens     = std::min(_capacity, _tokens + elapsed.count() * _rate);
+    _lastRefill = now;
+
+    if (_tokens < 1.0)
+    {
+        return false;
+    }
+
+    _tokens -= 1.0;
+
+    return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2016+ AzerothCore <www.azerothcore.org>, released under GNU AGPL v3 license: https://github.com/azerothcore/azerothcore-wotlk/blob/master/LICENSE
+ */
+
+#ifndef AUCTION_HOUSE_BOT_TOKEN_BUCKET_H
+#define AUCTION_HOUSE_BOT_TOKEN_BUCKET_H
+
+#include <chrono>
+
+#include "Common.h"
+
+// =============================================================================
+// Token bucket: limits the rate of an operation while allowing short bursts
+// =============================================================================
+
+class AHBTokenBucket
+{
+private:
+    double _rate;     // Tokens added every second, zero means unlimited
+    double _capacity; // Maximum amount of tokens that can be saved
+    double _tokens;
+
+    std::chrono::steady_clock::time_point _lastRefill;
+
+public:
+    AHBTokenBucket();
+
+    //
+    // The bucket starts full: a burst of the given seconds is allowed right away
+    //
+
+    void Configure (uint32 ratePerSecond, uint32 burstSeconds);
+
+    bool TryConsume();
+};
+
+#endif /* AUCTION_HOUSE_BOT_TOKEN_BUCKET_H */
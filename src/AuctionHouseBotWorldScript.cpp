@@ -7,6 +7,7 @@
 
 #include "AuctionHouseBot.h"
 #include "AuctionHouseBotCommon.h"
+#include "AuctionHouseBotConfig.h"
 #include "AuctionHouseBotWorldScript.h"
 
 // =============================================================================
@@ -15,7 +16,8 @@
 
 AHBot_WorldScript::AHBot_WorldScript() : WorldScript("AHBot_WorldScript", {
     WORLDHOOK_ON_BEFORE_CONFIG_LOAD,
-    WORLDHOOK_ON_STARTUP
+    WORLDHOOK_ON_STARTUP,
+    WORLDHOOK_ON_UPDATE
 })
 {
 
@@ -104,24 +106,25 @@ void AHBot_WorldScript::OnBeforeConfigLoad(bool reload)
         }
 
         //
-        // Clear the bots array; this way they wont be used anymore during the initialization stage.
+        // A rebuild still running is based on outdated settings: wait for it and throw it away
         //
 
-        DeleteBots();
-
-        //
-        // Reload the configuration for the auction houses
-        //
-
-        gAllianceConfig->Initialize(gBotsId);
-        gHordeConfig->Initialize   (gBotsId);
-        gNeutralConfig->Initialize (gBotsId);
+        if (_pendingConfigs.valid())
+        {
+            for (AHBConfig* config : _pendingConfigs.get())
+            {
+                delete config;
+            }
+        }
 
         //
-        // Start again the bots
+        // Read the configuration file now, a further reload could change it under the worker.
+        // Build the rest of the configurations in the background, the bots keep working with
+        // the current ones until they are published by the world update.
         //
 
-        PopulateBots();
+        gConfigsRebuilding = true;
+        _pendingConfigs    = std::async(std::launch::async, &AHBot_WorldScript::BuildConfigs, ReadConfigs());
     }
 }
 
@@ -130,15 +133,98 @@ void AHBot_WorldScript::OnStartup()
     LOG_INFO("server.loading", "Initialize AuctionHouseBot...");
 
     //
-    // Initialize the configuration (done only once at startup)
+    // Initialize the configuration and start the bots, the world is not running yet so there is no need to wait
+    //
+
+    PublishConfigs(BuildConfigs(ReadConfigs()));
+}
+
+void AHBot_WorldScript::OnUpdate(uint32 /*diff*/)
+{
+    //
+    // Publish the configurations rebuilt after a reload as soon as they are ready
+    //
+
+    if (!_pendingConfigs.valid())
+    {
+        return;
+    }
+
+    if (_pendingConfigs.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
+
+    PublishConfigs(_pendingConfigs.get());
+}
+
+AHBConfigSet AHBot_WorldScript::ReadConfigs()
+{
+    //
+    // The configuration manager is not thread safe: the options are read from the world thread only
     //
 
-    gAllianceConfig->Initialize(gBotsId);
-    gHordeConfig->Initialize   (gBotsId);
-    gNeutralConfig->Initialize (gBotsId);
+    AHBConfigSet configs = { new AHBConfig(2), new AHBConfig(6), new AHBConfig(7) };
+
+    for (AHBConfig* config : configs)
+    {
+        config->InitializeFromFile();
+    }
+
+    return configs;
+}
+
+AHBConfigSet AHBot_WorldScript::BuildConfigs(AHBConfigSet configs)
+{
+    //
+    // Only the database and the item templates are read here, so this can run on any thread
+    //
+
+    AHBSqlSettings                    settings = AHBConfig::LoadSqlSettings();
+    std::shared_ptr<AHBCatalog const> catalog  = AHBCatalog::Load(configs[0]->DebugOutConfig, configs[0]->Profession_Items);
+
+    for (AHBConfig* config : configs)
+    {
+        config->Initialize(settings, catalog);
+    }
+
+    return configs;
+}
+
+void AHBot_WorldScript::PublishConfigs(AHBConfigSet configs)
+{
+    //
+    // The bots and the auction house hooks are the only users of the configurations, and both run
+    // on the world thread: once the bots are gone the old configurations can be replaced and freed
+    //
+
+    DeleteBots();
+
+    //
+    // The auctions must be counted now, the market may have changed while the configurations were built.
+    // What the old configurations learned while running is taken over before they are freed.
+    //
+
+    AHBConfigSet previous = { gAllianceConfig, gHordeConfig, gNeutralConfig };
+
+    for (uint32 i = 0; i < AHB_HOUSES; ++i)
+    {
+        configs[i]->InitializeMarket(gBotsId, previous[i]);
+    }
+
+    gAllianceConfig = configs[0];
+    gHordeConfig    = configs[1];
+    gNeutralConfig  = configs[2];
+
+    gConfigsRebuilding = false;
+
+    for (AHBConfig* config : previous)
+    {
+        delete config;
+    }
 
     //
-    // Starts the bots
+    // Start again the bots
     //
 
     PopulateBots();
@@ -5,8 +5,21 @@
 #ifndef AUCTION_HOUSE_BOT_WORLD_SCRIPT_H
 #define AUCTION_HOUSE_BOT_WORLD_SCRIPT_H
 
+#include <array>
+#include <future>
+
 #include "ScriptMgr.h"
 
+#include "AuctionHouseBotCommon.h"
+
+class AHBConfig;
+
+//
+// Configurations of the alliance, horde and neutral auction houses
+//
+
+typedef std::array<AHBConfig*, AHB_HOUSES> AHBConfigSet;
+
 // =============================================================================
 // Interaction with the world core mechanisms
 // =============================================================================
@@ -14,14 +27,21 @@
 class AHBot_WorldScript : public WorldScript
 {
 private:
+    std::future<AHBConfigSet> _pendingConfigs; // Configurations being rebuilt after a reload
+
     void DeleteBots();
     void PopulateBots();
 
+    static AHBConfigSet ReadConfigs();
+    static AHBConfigSet BuildConfigs(AHBConfigSet configs);
+    void PublishConfigs(AHBConfigSet configs);
+
 public:
     AHBot_WorldScript();
 
     void OnBeforeConfigLoad(bool reload) override;
     void OnStartup() override;
+    void OnUpdate(uint32 diff) override;
 };
 
 #endif /* AUCTION_HOUSE_BOT_WORLD_SCRIPT_H */
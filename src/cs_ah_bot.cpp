@@ -115,6 +115,16 @@ public:
 
         int l = strlen(opt);
 
+        //
+        // The configurations being rebuilt after a reload would overwrite any change made now
+        //
+
+        if (gConfigsRebuilding && strncmp(opt, "help", l) != 0)
+        {
+            handler->PSendSysMessage("The configuration is being reloaded, try again in a moment.");
+            return false;
+        }
+
         if (strncmp(opt, "buyer", l) == 0)
         {
             char* param1 = strtok(NULL, " ");